@@ -43,6 +43,8 @@ CommonArguments::CommonArguments()
 	                         "Exclude has the priority over the --include argument.", "exclude", "");
 	_ADD_ARGUMENT("include-from", "Include field map names from file. The file format is one name per line.", "include", "");
 	_ADD_ARGUMENT("exclude-from", "Exclude field map names from file. The file format is one name per line.", "exclude", "");
+	_ADD_ARGUMENT(_OPTION_NAMES("j", "jobs"), "Number of fields processed in parallel. "
+	                                          "0 (default) uses one thread per CPU core.", "jobs", "0");
 
 	_parser.addPositionalArgument("file", QCoreApplication::translate("Arguments", "Input file or directory."));
 }
@@ -70,6 +72,21 @@ QStringList CommonArguments::excludes() const
 	return _parser.values("exclude") + _excludesFromFile;
 }
 
+int CommonArguments::jobs() const
+{
+	return _parser.value("jobs").toInt();
+}
+
+void CommonArguments::checkJobs() const
+{
+	bool ok;
+	if (_parser.value("jobs").toInt(&ok) < 0 || !ok) {
+		qWarning() << qPrintable(
+		    QCoreApplication::translate("Arguments", "Error: --jobs must be a positive number"));
+		exit(1);
+	}
+}
+
 QStringList CommonArguments::searchFiles(const QString &path)
 {
 	qsizetype index = path.lastIndexOf('/');
@@ -47,8 +47,10 @@ public:
 	QString inputFormat() const;
 	QStringList includes() const;
 	QStringList excludes() const;
+	int jobs() const;
 protected:
 	QStringList wilcardParse();
+	void checkJobs() const;
 	void mapNamesFromFiles();
 	static QStringList mapNamesFromFile(const QString &path);
 	static QStringList searchFiles(const QString &path);
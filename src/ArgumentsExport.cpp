@@ -97,6 +97,8 @@ void ArgumentsExport::parse()
 		exit(1);
 	}
 
+	checkJobs();
+
 	if ((_parser.value("music") == "psf" || _parser.value("music") == "minipsf") && !_parser.isSet("psf-lib-path")) {
 		qWarning() << qPrintable(
 		    QCoreApplication::translate("Arguments", "Error: --psf-lib-path is required with --music psf/minipsf"));
@@ -84,6 +84,8 @@ void ArgumentsPatch::parse()
 		exit(1);
 	}
 
+	checkJobs();
+
 	QStringList paths = wilcardParse();
 	if (!paths.isEmpty()) {
 		_path = paths.first();
@@ -22,6 +22,7 @@
 #include "core/field/FieldArchivePS.h"
 #include "core/field/FieldArchivePC.h"
 #include "core/field/BackgroundFilePC.h"
+#include "core/FF7Font.h"
 #include <iostream>
 
 void CLIObserver::setObserverValue(int value)
@@ -56,6 +57,7 @@ bool CLIObserver::observerRetry(const QString &message)
 }
 
 CLIObserver CLI::observer;
+int CLI::exitCode = 0;
 
 void CLI::commandExport()
 {
@@ -123,11 +125,27 @@ void CLI::commandExport()
 		toExport.insert(FieldArchive::Chunks, argsExport.chunkFormat());
 	}
 
+	fieldArchive->setJobCount(argsExport.jobs());
+	// Read only
+	fieldArchive->io()->setMemoryMapped(true);
+
+	QElapsedTimer timer;
+	timer.start();
+
 	if (!fieldArchive->exportation(selectedFields, argsExport.destination(),
 								   argsExport.force(), toExport, &tags)) {
 		qWarning() << qPrintable(QCoreApplication::translate("CLI", "An error occured when exporting"));
 	}
 
+	if (toExport.contains(FieldArchive::Backgrounds)) {
+		const double seconds = qMax(qint64(1), timer.elapsed()) / 1000.0;
+		const qsizetype imageCount = fieldArchive->exportedImageCount();
+		qInfo() << qPrintable(QCoreApplication::translate("CLI", "%1 images exported in %2 s (%3 images/s)")
+		                      .arg(imageCount)
+		                      .arg(seconds, 0, 'f', 2)
+		                      .arg(imageCount / seconds, 0, 'f', 1));
+	}
+
 	delete fieldArchive;
 }
 
@@ -178,76 +196,89 @@ void CLI::commandPatch()
 		}
 	}
 
-	observer.setObserverMaximum(uint(selectedFields.size()));
+	fieldArchive->setJobCount(argsPatch.jobs());
 
-	int i = 0;
+	const bool isPC = fieldArchive->isPC(),
+	        removeDialogs = argsPatch.removeDialogs(),
+	        emptyUnusedTexts = argsPatch.emptyUnusedTexts(),
+	        removeEncounters = argsPatch.removeEncounters(),
+	        autosizeTextWindows = argsPatch.autosizeTextWindows(),
+	        cleanModelLoader = argsPatch.cleanModelLoader(),
+	        repairBackgrounds = argsPatch.repairBackgrounds(),
+	        removeTilesSections = argsPatch.removeTilesSections();
 
-	for (const int &mapID : selectedFields) {
-		Field *field = fieldArchive->field(mapID);
-		if (field != nullptr) {
-			if (argsPatch.removeDialogs() && field->scriptsAndTexts()->isOpen()) {
-				field->scriptsAndTexts()->removeTexts();
-				if (field->scriptsAndTexts()->isModified() && !field->isModified()) {
-					field->setModified(true);
-				}
-			}
+	// calcSize() cannot read the config from the workers
+	const FF7Font::SizeSettings sizeSettings = FF7Font::sizeSettings();
 
-			if (argsPatch.emptyUnusedTexts() && field->scriptsAndTexts()->isOpen()) {
-				field->scriptsAndTexts()->cleanTexts();
-				if (field->scriptsAndTexts()->isModified() && !field->isModified()) {
-					field->setModified(true);
-				}
-			}
+	// Runs on worker threads, one field at a time
+	const bool patched = fieldArchive->patchFields(selectedFields, [&](Field *field) {
+		bool modified = false;
 
-			if (argsPatch.removeEncounters() && field->encounter()->isOpen()) {
-				field->encounter()->setBattleEnabled(EncounterFile::Table1, false);
-				field->encounter()->setBattleEnabled(EncounterFile::Table2, false);
-				if (field->encounter()->isModified() && !field->isModified()) {
-					field->setModified(true);
-				}
-			}
+		if (removeDialogs && field->scriptsAndTexts()->isOpen()) {
+			field->scriptsAndTexts()->removeTexts();
+			modified = modified || field->scriptsAndTexts()->isModified();
+		}
 
-			if (argsPatch.autosizeTextWindows() && field->scriptsAndTexts()->isOpen()) {
-				field->scriptsAndTexts()->autosizeTextWindows();
-				if (field->scriptsAndTexts()->isModified() && !field->isModified()) {
-					field->setModified(true);
-				}
-			}
+		if (emptyUnusedTexts && field->scriptsAndTexts()->isOpen()) {
+			field->scriptsAndTexts()->cleanTexts();
+			modified = modified || field->scriptsAndTexts()->isModified();
+		}
 
-			if (fieldArchive->isPC()) {
-				if (argsPatch.cleanModelLoader()) {
-					FieldPC *fieldPC = static_cast<FieldPC *>(field);
-					FieldModelLoaderPC *modelLoader = fieldPC->fieldModelLoader();
-					if (modelLoader->isOpen()) {
-						modelLoader->clean();
-						if (modelLoader->isModified() && !field->isModified()) {
-							field->setModified(true);
-						}
-					}
-				}
+		if (removeEncounters && field->encounter()->isOpen()) {
+			field->encounter()->setBattleEnabled(EncounterFile::Table1, false);
+			field->encounter()->setBattleEnabled(EncounterFile::Table2, false);
+			modified = modified || field->encounter()->isModified();
+		}
 
-				if (argsPatch.repairBackgrounds()
-				    && (field->name().toLower() == "lastmap"
-				        || field->name().toLower() == "fr_e")) {
-					BackgroundFilePC *bg = static_cast<BackgroundFilePC *>(field->background());
-					if (bg->isOpen() && bg->repair()) {
-						field->setModified(true);
-					}
+		if (autosizeTextWindows && field->scriptsAndTexts()->isOpen()) {
+			field->scriptsAndTexts()->autosizeTextWindows(sizeSettings);
+			modified = modified || field->scriptsAndTexts()->isModified();
+		}
+
+		if (isPC) {
+			if (cleanModelLoader) {
+				FieldPC *fieldPC = static_cast<FieldPC *>(field);
+				FieldModelLoaderPC *modelLoader = fieldPC->fieldModelLoader();
+				if (modelLoader->isOpen()) {
+					modelLoader->clean();
+					modified = modified || modelLoader->isModified();
 				}
+			}
 
-				if (argsPatch.removeTilesSections()) {
-					FieldPC *fieldPC = static_cast<FieldPC *>(field);
-					fieldPC->setRemoveUnusedSection(true);
-					field->setModified(true);
+			if (repairBackgrounds
+			    && (field->name().toLower() == "lastmap"
+			        || field->name().toLower() == "fr_e")) {
+				BackgroundFilePC *bg = static_cast<BackgroundFilePC *>(field->background());
+				if (bg->isOpen() && bg->repair()) {
+					modified = true;
 				}
 			}
+
+			if (removeTilesSections) {
+				FieldPC *fieldPC = static_cast<FieldPC *>(field);
+				fieldPC->setRemoveUnusedSection(true);
+				modified = true;
+			}
 		}
 
-		observer.setObserverValue(i++);
+		return modified;
+	});
+
+	if (!patched) {
+		qWarning() << qPrintable(QCoreApplication::translate("CLI", "Error")) << qPrintable(QCoreApplication::translate("CLI", "Unable to patch the fields"));
+		delete fieldArchive;
+		exitCode = 1;
+		return;
 	}
 
 	fieldArchive->save(argsPatch.targetFile());
 
+	const qint64 peakMemory = fieldArchive->io()->savePeakMemory();
+	if (peakMemory > 0) {
+		qInfo() << qPrintable(QCoreApplication::translate("CLI", "Peak memory during the save: %1 MiB")
+		                      .arg(double(peakMemory) / (1024.0 * 1024.0), 0, 'f', 1));
+	}
+
 	delete fieldArchive;
 }
 
@@ -321,13 +352,14 @@ FieldArchive *CLI::openFieldArchive(const QString &ext, const QString &path)
 	if (!out.isEmpty()) {
 		qWarning() << qPrintable(QCoreApplication::translate("CLI", "Error")) << qPrintable(out);
 		delete fieldArchive;
+		exitCode = 1;
 		return nullptr;
 	}
 
 	return fieldArchive;
 }
 
-void CLI::exec()
+int CLI::exec()
 {
 	Arguments args;
 	if (args.help()) {
@@ -344,4 +376,6 @@ void CLI::exec()
 		commandPatch();
 		break;
 	}
+
+	return exitCode;
 }
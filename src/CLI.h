@@ -46,10 +46,11 @@ private:
 class CLI
 {
 public:
-	static void exec();
+	static int exec();
 private:
 	static void commandExport();
 	static void commandPatch();
 	static FieldArchive *openFieldArchive(const QString &ext, const QString &path);
 	static CLIObserver observer;
+	static int exitCode;
 };
@@ -452,6 +452,8 @@ int Window::closeFile(bool quit)
 		if (varDialog) {
 			varDialog->setFieldArchive(nullptr);
 		}
+		// Stops the Find All before the archive is deleted
+		searchDialog->setFieldArchive(nullptr);
 
 		if (_lgpWidget != nullptr) {
 			_mainStackedWidget->removeWidget(_lgpWidget);
@@ -480,7 +482,6 @@ int Window::closeFile(bool quit)
 		}
 		setWindowModified(false);
 		setWindowTitle();
-		searchDialog->setFieldArchive(nullptr);
 
 		actionSave->setEnabled(false);
 		actionSaveAs->setEnabled(false);
@@ -903,6 +904,7 @@ void Window::open(const QString &filePath, FieldArchiveIO::Type type, bool isPS)
 	//fieldArchive->printModelLoaders("field-model-loaders.txt", false);
 	//fieldArchive->printScripts("field-scripts.txt");
 	//fieldArchive->searchAll();
+	//fieldArchive->benchmarkFieldDataCache();
 #endif
 }
 
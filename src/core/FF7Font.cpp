@@ -428,20 +428,37 @@ QSize FF7Font::calcSize(const QByteArray &ff7String)
 }
 
 QSize FF7Font::calcSize(const QByteArray &ff7String, QList<int> &pagesPos)
+{
+	return calcSize(ff7String, pagesPos, sizeSettings());
+}
+
+FF7Font::SizeSettings FF7Font::sizeSettings()
 {
 	if (biggestCharWidth <= 0) {
 		biggestCharWidth = calcFF7StringWidth(FF7String("W", false));
 	}
 
-	const int baseWidth = 8 + Config::value("autoSizeMarginRight", 14).toInt();
+	SizeSettings settings;
+	settings.marginRight = Config::value("autoSizeMarginRight", 14).toInt();
+	settings.spacedCharactersWidth = Config::value("spacedCharactersWidth", 13).toInt();
+	settings.choiceWidth = Config::value("choiceWidth", 10).toInt();
+	settings.tabWidth = Config::value("tabWidth", 4).toInt();
+	settings.jp = Config::value("jp_txt", false).toBool();
+
+	return settings;
+}
+
+QSize FF7Font::calcSize(const QByteArray &ff7String, QList<int> &pagesPos, const SizeSettings &settings)
+{
+	const int baseWidth = 8 + settings.marginRight;
 	int line=0, width=baseWidth - 3, height=25, maxW=0, maxH=0;
 	qsizetype size=ff7String.size();
 	pagesPos.clear();
 	pagesPos.append(0);
-	bool jp = Config::value("jp_txt", false).toBool(), spaced_characters=false;
-	int spacedCharsW = Config::value("spacedCharactersWidth", 13).toInt(),
-	    choiceW = Config::value("choiceWidth", 10).toInt(),
-	    tabW = Config::value("tabWidth", 4).toInt();
+	bool jp = settings.jp, spaced_characters=false;
+	int spacedCharsW = settings.spacedCharactersWidth,
+	    choiceW = settings.choiceWidth,
+	    tabW = settings.tabWidth;
 
 	for (int i=0; i<size; ++i) {
 		quint8 caract = quint8(ff7String.at(i));
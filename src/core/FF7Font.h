@@ -23,6 +23,12 @@
 class FF7Font
 {
 public:
+	// Config values used by calcSize()
+	struct SizeSettings {
+		int marginRight, spacedCharactersWidth, choiceWidth, tabWidth;
+		bool jp;
+	};
+
 	FF7Font(WindowBinFile *windowBinFile, const QByteArray &txtFileData);
 	WindowBinFile *windowBinFile() const;
 	const QList<QStringList> &tables() const;
@@ -50,6 +56,10 @@ public:
 	static const QString &fontDirPath();
 	static QSize calcSize(const QByteArray &ff7String);
 	static QSize calcSize(const QByteArray &ff7String, QList<int> &pagesPos);
+	// To call from several threads, with settings read before by sizeSettings()
+	static QSize calcSize(const QByteArray &ff7String, QList<int> &pagesPos, const SizeSettings &settings);
+	// Reads the config, not thread safe
+	static SizeSettings sizeSettings();
 	static quint8 charW(int tableId, int charId);
 	static quint8 leftPadding(int tableId, int charId);
 	static quint8 charFullWidth(int tableId, int charId);
@@ -0,0 +1,397 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "LgpWriter.h"
+
+#define LGP_COMPANY_NAME_SIZE  12
+#define LGP_HEADER_SIZE        (LGP_COMPANY_NAME_SIZE + 4)
+#define LGP_TOC_ENTRY_SIZE     27
+#define LGP_FILE_NAME_SIZE     20
+#define LGP_ENTRY_HEADER_SIZE  (LGP_FILE_NAME_SIZE + 4)
+#define LGP_COPY_BUFFER_SIZE   (1024 * 1024)
+
+LgpWriter::LgpWriter(const QString &sourcePath) :
+    _sourcePath(sourcePath), _memory(0), _peakMemory(0), _error(NoError)
+{
+}
+
+void LgpWriter::setEntryData(const QString &name, const QByteArray &data)
+{
+	const QString key = name.toLower();
+	auto it = _entries.find(key);
+	if (it != _entries.end()) {
+		_memory -= it->size();
+		*it = data;
+	} else {
+		_entries.insert(key, data);
+	}
+	addMemory(data.size());
+}
+
+LgpWriter::Error LgpWriter::readToc(QFile &source, QByteArray &header, QList<TocEntry> &toc)
+{
+	header = source.read(LGP_HEADER_SIZE);
+	if (header.size() != LGP_HEADER_SIZE) {
+		return InvalidError;
+	}
+
+	qint32 fileCount = qFromLittleEndian<qint32>(header.constData() + LGP_COMPANY_NAME_SIZE);
+	qint64 tocEnd = LGP_HEADER_SIZE + qint64(fileCount) * LGP_TOC_ENTRY_SIZE;
+	if (fileCount <= 0 || tocEnd > source.size()) {
+		return InvalidError;
+	}
+
+	header.append(source.read(tocEnd - LGP_HEADER_SIZE));
+	if (header.size() != tocEnd) {
+		return InvalidError;
+	}
+
+	toc.reserve(fileCount);
+	qint64 dataStart = source.size();
+
+	for (int i = 0; i < fileCount; ++i) {
+		const char *entry = header.constData() + LGP_HEADER_SIZE + i * LGP_TOC_ENTRY_SIZE;
+		TocEntry tocEntry;
+		tocEntry.name = QString::fromLatin1(entry, int(qstrnlen(entry, LGP_FILE_NAME_SIZE)));
+		tocEntry.position = qFromLittleEndian<quint32>(entry + LGP_FILE_NAME_SIZE);
+		tocEntry.newPosition = tocEntry.position;
+		tocEntry.tocIndex = i;
+
+		char size[4];
+		if (tocEntry.position < tocEnd
+		        || !source.seek(tocEntry.position + LGP_FILE_NAME_SIZE)
+		        || source.read(size, 4) != 4) {
+			return InvalidError;
+		}
+		tocEntry.size = qFromLittleEndian<quint32>(size);
+		if (tocEntry.position + qint64(LGP_ENTRY_HEADER_SIZE) + tocEntry.size > source.size()) {
+			return InvalidError;
+		}
+
+		dataStart = qMin(dataStart, qint64(tocEntry.position));
+		toc.append(tocEntry);
+	}
+
+	// The lookup table and the conflict table are between the TOC and the data
+	if (!source.seek(tocEnd)) {
+		return InvalidError;
+	}
+	header.append(source.read(dataStart - tocEnd));
+
+	std::sort(toc.begin(), toc.end(), [](const TocEntry &e1, const TocEntry &e2) {
+		return e1.position < e2.position;
+	});
+
+	// Entries sharing their data or overlapping cannot be moved separately
+	for (int i = 1; i < toc.size(); ++i) {
+		const TocEntry &previous = toc.at(i - 1);
+		if (previous.position + qint64(LGP_ENTRY_HEADER_SIZE) + previous.size > toc.at(i).position) {
+			return SharedDataError;
+		}
+	}
+
+	return header.size() == dataStart ? NoError : InvalidError;
+}
+
+bool LgpWriter::canWrite()
+{
+	QFile source(_sourcePath);
+	if (!source.open(QIODevice::ReadOnly)) {
+		_error = OpenError;
+		return false;
+	}
+
+	QByteArray header;
+	QList<TocEntry> toc;
+	_error = readToc(source, header, toc);
+
+	return _error == NoError;
+}
+
+bool LgpWriter::copy(QFile &source, QIODevice &destination, qint64 size, QByteArray &buffer)
+{
+	while (size > 0) {
+		qint64 r = source.read(buffer.data(), qMin(size, qint64(buffer.size())));
+		if (r <= 0 || destination.write(buffer.constData(), r) != r) {
+			return false;
+		}
+		size -= r;
+	}
+
+	return true;
+}
+
+bool LgpWriter::write(const QString &destination, ArchiveObserver *observer)
+{
+	_error = NoError;
+
+	QFile source(_sourcePath);
+	if (!source.open(QIODevice::ReadOnly)) {
+		_error = OpenError;
+		return false;
+	}
+
+	QByteArray header;
+	QList<TocEntry> toc;
+
+	_error = readToc(source, header, toc);
+	if (_error != NoError) {
+		return false;
+	}
+
+	const qint64 entriesMemory = _memory;
+	auto restoreMemory = qScopeGuard([this, entriesMemory] {
+		_memory = entriesMemory;
+	});
+	addMemory(header.size());
+
+	// Every replaced entry has to exist once in the source archive
+	qsizetype replacedCount = 0;
+	for (const TocEntry &entry : qAsConst(toc)) {
+		if (_entries.contains(entry.name.toLower())) {
+			++replacedCount;
+		}
+	}
+	if (replacedCount != _entries.size()) {
+		_error = InvalidError;
+		return false;
+	}
+
+	// New positions, patched in the TOC before writing anything
+	const TocEntry &last = toc.last();
+	qint64 tailPosition = last.position + qint64(LGP_ENTRY_HEADER_SIZE) + last.size,
+	        position = header.size();
+	for (TocEntry &entry : toc) {
+		auto it = _entries.constFind(entry.name.toLower());
+		if (it != _entries.constEnd()) {
+			entry.size = quint32(it->size());
+		}
+		if (position > qint64(0xFFFFFFFF)) {
+			_error = InvalidError;
+			return false;
+		}
+		entry.newPosition = quint32(position);
+		qToLittleEndian<quint32>(entry.newPosition, header.data() + LGP_HEADER_SIZE
+		                         + entry.tocIndex * LGP_TOC_ENTRY_SIZE + LGP_FILE_NAME_SIZE);
+		position += LGP_ENTRY_HEADER_SIZE + entry.size;
+	}
+
+	QSaveFile destinationFile(destination);
+	if (!destinationFile.open(QIODevice::WriteOnly)) {
+		_error = OpenTempError;
+		return false;
+	}
+
+	if (observer) {
+		observer->setObserverMaximum(uint(toc.size()));
+	}
+
+	QByteArray buffer(LGP_COPY_BUFFER_SIZE, Qt::Uninitialized);
+	addMemory(buffer.size());
+
+	if (destinationFile.write(header) != header.size()) {
+		destinationFile.cancelWriting();
+		_error = CopyError;
+		return false;
+	}
+
+	int i = 0;
+	for (const TocEntry &entry : qAsConst(toc)) {
+		if (observer) {
+			if (observer->observerWasCanceled()) {
+				destinationFile.cancelWriting();
+				_error = AbortError;
+				return false;
+			}
+			observer->setObserverValue(i++);
+		}
+
+		if (!source.seek(entry.position)) {
+			destinationFile.cancelWriting();
+			_error = CopyError;
+			return false;
+		}
+
+		bool ok;
+		auto it = _entries.constFind(entry.name.toLower());
+		if (it != _entries.constEnd()) {
+			char size[4];
+			qToLittleEndian<quint32>(entry.size, size);
+			ok = copy(source, destinationFile, LGP_FILE_NAME_SIZE, buffer)
+			        && destinationFile.write(size, 4) == 4
+			        && destinationFile.write(*it) == it->size();
+		} else {
+			ok = copy(source, destinationFile, LGP_ENTRY_HEADER_SIZE + entry.size, buffer);
+		}
+
+		if (!ok) {
+			destinationFile.cancelWriting();
+			_error = CopyError;
+			return false;
+		}
+	}
+
+	// Product name
+	if (!source.seek(tailPosition)
+	        || !copy(source, destinationFile, source.size() - tailPosition, buffer)) {
+		destinationFile.cancelWriting();
+		_error = CopyError;
+		return false;
+	}
+
+	source.close();
+
+	if (!destinationFile.commit()) {
+		_error = RenameError;
+		return false;
+	}
+
+	return true;
+}
+
+bool LgpWriter::writeInPlace(int maxFragmentation, ArchiveObserver *observer)
+{
+	_error = NoError;
+
+	QFile source(_sourcePath);
+	if (!source.open(QIODevice::ReadWrite)) {
+		_error = OpenError;
+		return false;
+	}
+
+	QByteArray header;
+	QList<TocEntry> toc;
+
+	_error = readToc(source, header, toc);
+	if (_error != NoError) {
+		return false;
+	}
+
+	const qint64 entriesMemory = _memory;
+	auto restoreMemory = qScopeGuard([this, entriesMemory] {
+		_memory = entriesMemory;
+	});
+	addMemory(header.size());
+
+	const TocEntry &last = toc.last();
+	const qint64 lastEnd = last.position + qint64(LGP_ENTRY_HEADER_SIZE) + last.size;
+	qint64 usedSize = header.size(), appendPosition = lastEnd;
+	QList<int> replaced, appended;
+
+	for (int i = 0; i < toc.size(); ++i) {
+		TocEntry &entry = toc[i];
+		auto it = _entries.constFind(entry.name.toLower());
+		if (it != _entries.constEnd()) {
+			const qint64 slotEnd = i + 1 < toc.size() ? toc.at(i + 1).position : -1;
+			entry.size = quint32(it->size());
+			replaced.append(i);
+			// The last entry can grow in place
+			if (slotEnd >= 0 && entry.position + qint64(LGP_ENTRY_HEADER_SIZE) + entry.size > slotEnd) {
+				appended.append(i);
+			} else if (slotEnd < 0) {
+				appendPosition = entry.position + qint64(LGP_ENTRY_HEADER_SIZE) + entry.size;
+			}
+		}
+		usedSize += LGP_ENTRY_HEADER_SIZE + entry.size;
+	}
+
+	if (replaced.size() != _entries.size()) {
+		_error = InvalidError;
+		return false;
+	}
+
+	for (int i : qAsConst(appended)) {
+		TocEntry &entry = toc[i];
+		if (appendPosition > qint64(0xFFFFFFFF)) {
+			_error = InvalidError;
+			return false;
+		}
+		entry.newPosition = quint32(appendPosition);
+		appendPosition += LGP_ENTRY_HEADER_SIZE + entry.size;
+	}
+
+	// Product name
+	if (!source.seek(lastEnd)) {
+		_error = CopyError;
+		return false;
+	}
+	const QByteArray tail = source.readAll();
+	addMemory(tail.size());
+
+	const qint64 newSize = appendPosition + tail.size();
+	usedSize += tail.size();
+
+	if ((newSize - usedSize) * 100 > qint64(maxFragmentation) * newSize) {
+		_error = FragmentedError;
+		return false;
+	}
+
+	if (observer) {
+		observer->setObserverMaximum(uint(replaced.size()));
+	}
+
+	// Data first, then the TOC
+	int progress = 0;
+	for (int i : qAsConst(replaced)) {
+		if (observer) {
+			if (observer->observerWasCanceled()) {
+				_error = AbortError;
+				return false;
+			}
+			observer->setObserverValue(progress++);
+		}
+
+		const TocEntry &entry = toc.at(i);
+		QByteArray entryHeader(LGP_ENTRY_HEADER_SIZE, '\0');
+		QByteArray name = entry.name.toLatin1().left(LGP_FILE_NAME_SIZE);
+		memcpy(entryHeader.data(), name.constData(), size_t(name.size()));
+		qToLittleEndian<quint32>(entry.size, entryHeader.data() + LGP_FILE_NAME_SIZE);
+
+		if (!source.seek(entry.newPosition)
+		        || source.write(entryHeader) != entryHeader.size()
+		        || source.write(_entries.value(entry.name.toLower())) != qint64(entry.size)) {
+			_error = CopyError;
+			return false;
+		}
+	}
+
+	if (!source.seek(appendPosition) || source.write(tail) != tail.size()
+	        || !source.resize(newSize) || !source.flush()) {
+		_error = CopyError;
+		return false;
+	}
+
+	for (int i : qAsConst(appended)) {
+		const TocEntry &entry = toc.at(i);
+		char position[4];
+		qToLittleEndian<quint32>(entry.newPosition, position);
+
+		if (!source.seek(LGP_HEADER_SIZE + qint64(entry.tocIndex) * LGP_TOC_ENTRY_SIZE
+		                 + LGP_FILE_NAME_SIZE)
+		        || source.write(position, 4) != 4) {
+			_error = CopyError;
+			return false;
+		}
+	}
+
+	if (!source.flush()) {
+		_error = CopyError;
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,87 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include <Archive>
+
+/*
+ * Writes a LGP archive in one sequential pass, replacing the data
+ * of some entries.
+ * The header, the TOC, the lookup table and the conflict table are
+ * copied from the source archive with updated positions, the unchanged
+ * entries are copied raw (no decompression), so the file list must be
+ * the same as in the source archive: no addition, no removal, no rename.
+ * The source archive can also be updated in place, see writeInPlace().
+ */
+class LgpWriter
+{
+public:
+	enum Error {
+		NoError, OpenError, OpenTempError, InvalidError,
+		CopyError, RenameError, AbortError, FragmentedError,
+		SharedDataError
+	};
+
+	explicit LgpWriter(const QString &sourcePath);
+
+	// Entry names are case insensitive
+	void setEntryData(const QString &name, const QByteArray &data);
+	inline bool hasEntries() const {
+		return !_entries.isEmpty();
+	}
+	// False when the source archive cannot be written by this class,
+	// for example with SharedDataError when entries share their data
+	bool canWrite();
+	// The source archive must not be opened elsewhere on Windows
+	// when destination == source
+	bool write(const QString &destination, ArchiveObserver *observer = nullptr);
+	// Replaced entries are written in their old slot when they fit,
+	// otherwise at the end of the archive, then the TOC is updated.
+	// Fails with FragmentedError without writing anything when the unused
+	// space would exceed maxFragmentation percents of the archive.
+	// Not atomic: an interrupted write may corrupt the archive
+	bool writeInPlace(int maxFragmentation, ArchiveObserver *observer = nullptr);
+
+	inline Error error() const {
+		return _error;
+	}
+	// Maximum of bytes held by the writer during setEntryData() and the writes
+	inline qint64 peakMemory() const {
+		return _peakMemory;
+	}
+private:
+	struct TocEntry {
+		QString name;
+		quint32 position, newPosition;
+		quint32 size;
+		int tocIndex;
+	};
+
+	Error readToc(QFile &source, QByteArray &header, QList<TocEntry> &toc);
+	bool copy(QFile &source, QIODevice &destination, qint64 size, QByteArray &buffer);
+	inline void addMemory(qint64 size) {
+		_memory += size;
+		_peakMemory = qMax(_peakMemory, _memory);
+	}
+
+	QString _sourcePath;
+	QHash<QString, QByteArray> _entries;
+	qint64 _memory, _peakMemory;
+	Error _error;
+};
@@ -0,0 +1,155 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "LzsDecoder.h"
+
+LzsDecoder::LzsDecoder() :
+    _srcPos(0), _srcEnd(0), _pos(0), _flags(0), _atEnd(true)
+{
+}
+
+LzsDecoder::LzsDecoder(const QByteArray &data) :
+    _data(data), _srcPos(0), _srcEnd(data.size()), _pos(0), _flags(0), _atEnd(false)
+{
+}
+
+LzsDecoder::LzsDecoder(const QByteArray &data, qsizetype offset, qsizetype size) :
+    _data(data), _srcPos(qBound(qsizetype(0), offset, data.size())),
+    _srcEnd(qBound(_srcPos, offset + size, data.size())),
+    _pos(0), _flags(0), _atEnd(false)
+{
+}
+
+qsizetype LzsDecoder::decompressTo(qsizetype max)
+{
+	if (_atEnd || (max >= 0 && _pos >= max)) {
+		return _pos;
+	}
+
+	const quint8 *begin = reinterpret_cast<const quint8 *>(_data.constData()),
+	        *src = begin + _srcPos,
+	        *end = begin + _srcEnd;
+	// A reference can write up to 18 bytes after max
+	qsizetype capacity = max >= 0 ? max + 18 : qMax((_srcEnd - _srcPos) * 4, qsizetype(4096)),
+	        pos = _pos;
+	if (capacity > _result.size()) {
+		_result.resize(capacity);
+	} else {
+		capacity = _result.size();
+	}
+	char *out = _result.data();
+	quint16 flags = _flags;
+
+	forever {
+		if (max >= 0 && pos >= max) {
+			break;
+		}
+
+		if (((flags >>= 1) & 0x100) == 0) {
+			if (src >= end) {
+				_atEnd = true;
+				break;
+			}
+			flags = *src++ | 0xFF00;
+		}
+
+		if (src >= end) {
+			_atEnd = true;
+			break;
+		}
+
+		if (pos + 18 > capacity) {
+			capacity *= 2;
+			_result.resize(capacity);
+			out = _result.data();
+		}
+
+		if (flags & 1) {
+			out[pos++] = char(*src++);
+		} else {
+			if (end - src < 2) {
+				_atEnd = true;
+				break;
+			}
+			quint32 offset = *src++;
+			quint8 length = *src++;
+			offset |= (length & 0xF0) << 4;
+			length = (length & 0xF) + 3;
+
+			// The offset is an absolute position in the 4 KiB ring buffer,
+			// which starts at 0xFEE and is initialized with zeroes
+			qsizetype distance = (quint32(pos) + 0x1000 + 0xFEE - offset) & 0xFFF;
+			if (distance == 0) {
+				distance = 0x1000;
+			}
+
+			for (quint8 i = 0; i < length; ++i, ++pos) {
+				out[pos] = pos >= distance ? out[pos - distance] : '\0';
+			}
+		}
+	}
+
+	_srcPos = src - begin;
+	_pos = pos;
+	_flags = flags;
+
+	if (_atEnd) {
+		_data = QByteArray();
+	}
+
+	return _pos;
+}
+
+QByteArray LzsDecoder::data(qsizetype position, qsizetype size) const
+{
+	if (position >= _pos) {
+		return QByteArray();
+	}
+
+	return QByteArray(_result.constData() + position,
+	                  size < 0 ? _pos - position : qMin(size, _pos - position));
+}
+
+QByteArray LzsDecoder::takeData()
+{
+	QByteArray ret = std::move(_result);
+	const qsizetype size = _pos;
+	*this = LzsDecoder();
+	ret.truncate(size);
+
+	return ret;
+}
+
+QByteArray LzsDecoder::decompress(const char *data, qsizetype size, qsizetype max)
+{
+	LzsDecoder decoder(QByteArray::fromRawData(data, size));
+	decoder.decompressTo(max);
+
+	return decoder.takeData();
+}
+
+QByteArray LzsDecoder::decompressAllWithHeader(const QByteArray &data)
+{
+	if (data.size() < 4) {
+		return QByteArray();
+	}
+
+	quint32 lzsSize;
+	memcpy(&lzsSize, data.constData(), 4);
+
+	return decompressAll(data.constData() + 4, qMin(qsizetype(lzsSize), data.size() - 4));
+}
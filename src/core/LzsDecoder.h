@@ -0,0 +1,78 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+
+/*
+ * Reentrant LZS decompressor.
+ * Unlike the ff7tk implementation, it does not use static buffers,
+ * so it can be used from several threads at the same time.
+ * An instance keeps its state between two decompressTo() calls,
+ * to decompress a file section by section in one pass.
+ */
+class LzsDecoder
+{
+public:
+	LzsDecoder();
+	// data without the LZS header
+	explicit LzsDecoder(const QByteArray &data);
+	// Decompresses size bytes of data from offset, data is shared, not copied
+	LzsDecoder(const QByteArray &data, qsizetype offset, qsizetype size);
+
+	// Decompresses at least max bytes (or everything when max < 0),
+	// resuming where the previous call stopped, returns size()
+	qsizetype decompressTo(qsizetype max);
+	inline bool atEnd() const {
+		return _atEnd;
+	}
+	// Decompressed size so far
+	inline qsizetype size() const {
+		return _pos;
+	}
+	// size < 0 means up to size()
+	QByteArray data(qsizetype position, qsizetype size = -1) const;
+	// Decompressed data shared without copy, only the first size() bytes
+	// are meaningful. Shared data are copied when the decompression resumes
+	inline const QByteArray &buffer() const {
+		return _result;
+	}
+	// Decompressed data so far, the decoder is reset
+	QByteArray takeData();
+	// Memory used by the state
+	inline qsizetype cost() const {
+		return _data.size() + _result.size();
+	}
+
+	static QByteArray decompress(const char *data, qsizetype size, qsizetype max);
+	static inline QByteArray decompress(const QByteArray &data, qsizetype max) {
+		return decompress(data.constData(), data.size(), max);
+	}
+	static inline QByteArray decompressAll(const char *data, qsizetype size) {
+		return decompress(data, size, -1);
+	}
+	static inline QByteArray decompressAll(const QByteArray &data) {
+		return decompressAll(data.constData(), data.size());
+	}
+	static QByteArray decompressAllWithHeader(const QByteArray &data);
+private:
+	QByteArray _data, _result;
+	qsizetype _srcPos, _srcEnd, _pos;
+	quint16 _flags;
+	bool _atEnd;
+};
@@ -0,0 +1,159 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "LzsEncoder.h"
+
+#define LZS_MIN_LENGTH  3
+#define LZS_MAX_LENGTH  18
+// Like the original compressor, the lookahead part
+// of the ring buffer is never referenced
+#define LZS_MAX_DISTANCE  (0x1000 - LZS_MAX_LENGTH)
+#define LZS_HASH_BITS   12
+
+struct LzsLevelParams {
+	int maxChain, niceLength;
+	bool lazy;
+};
+
+static const LzsLevelParams lzsLevels[] = {
+	{8, 8, false},              // Fast
+	{64, 16, true},             // Default
+	{4096, LZS_MAX_LENGTH, true} // MaxRatio
+};
+
+static inline quint32 lzsHash(const quint8 *data)
+{
+	return ((quint32(data[0]) << 16 | quint32(data[1]) << 8 | data[2])
+	        * 2654435761U) >> (32 - LZS_HASH_BITS);
+}
+
+QByteArray LzsEncoder::compress(const char *data, qsizetype size, Level level)
+{
+	const LzsLevelParams &params = lzsLevels[level];
+	const quint8 *src = reinterpret_cast<const quint8 *>(data);
+	// Last position inserted for each hash, and previous position with
+	// the same hash for each position of the window
+	std::vector<qint32> head(1 << LZS_HASH_BITS, -1), prev(0x1000, -1);
+	qsizetype inserted = 0;
+
+	QByteArray ret;
+	ret.reserve(size + size / 8 + 1);
+	qsizetype flagPos = 0;
+	int flagBit = 8;
+
+	auto insertUpTo = [&](qsizetype end) {
+		for (; inserted < end && inserted + LZS_MIN_LENGTH <= size; ++inserted) {
+			quint32 h = lzsHash(src + inserted);
+			prev[size_t(inserted & 0xFFF)] = head[h];
+			head[h] = qint32(inserted);
+		}
+	};
+
+	auto longestMatch = [&](qsizetype pos, qsizetype &matchPos) -> int {
+		insertUpTo(pos);
+
+		const int maxLength = int(qMin(qsizetype(LZS_MAX_LENGTH), size - pos));
+		if (maxLength < LZS_MIN_LENGTH) {
+			return 0;
+		}
+
+		int bestLength = 0, chain = params.maxChain;
+		qint32 candidate = head[lzsHash(src + pos)];
+
+		while (candidate >= 0 && pos - candidate <= LZS_MAX_DISTANCE && chain-- > 0) {
+			const quint8 *a = src + candidate, *b = src + pos;
+			if (a[bestLength] == b[bestLength]) {
+				int length = 0;
+				while (length < maxLength && a[length] == b[length]) {
+					++length;
+				}
+				if (length > bestLength) {
+					bestLength = length;
+					matchPos = candidate;
+					if (length >= params.niceLength || length == maxLength) {
+						break;
+					}
+				}
+			}
+			qint32 next = prev[size_t(candidate & 0xFFF)];
+			if (next >= candidate) {
+				break;
+			}
+			candidate = next;
+		}
+
+		return bestLength >= LZS_MIN_LENGTH ? bestLength : 0;
+	};
+
+	auto nextFlag = [&](bool literal) {
+		if (flagBit == 8) {
+			flagPos = ret.size();
+			ret.append('\0');
+			flagBit = 0;
+		}
+		if (literal) {
+			ret.data()[flagPos] = char(quint8(ret.at(flagPos)) | (1 << flagBit));
+		}
+		++flagBit;
+	};
+
+	qsizetype pos = 0;
+
+	while (pos < size) {
+		qsizetype matchPos = 0;
+		int length = longestMatch(pos, matchPos);
+
+		// Lazy matching: a literal then a longer match is better
+		while (params.lazy && length > 0 && length < params.niceLength && pos + 1 < size) {
+			qsizetype nextMatchPos = 0;
+			int nextLength = longestMatch(pos + 1, nextMatchPos);
+			if (nextLength <= length) {
+				break;
+			}
+			nextFlag(true);
+			ret.append(char(src[pos]));
+			++pos;
+			length = nextLength;
+			matchPos = nextMatchPos;
+		}
+
+		if (length > 0) {
+			// Absolute position in the ring buffer, which starts at 0xFEE
+			quint32 offset = quint32(matchPos + 0xFEE) & 0xFFF;
+			nextFlag(false);
+			ret.append(char(offset & 0xFF));
+			ret.append(char(((offset >> 4) & 0xF0) | quint32(length - LZS_MIN_LENGTH)));
+			pos += length;
+		} else {
+			nextFlag(true);
+			ret.append(char(src[pos]));
+			++pos;
+		}
+	}
+
+	return ret;
+}
+
+QByteArray LzsEncoder::compressWithHeader(const QByteArray &data, Level level)
+{
+	const QByteArray compressed = compress(data, level);
+	quint32 lzsSize = quint32(compressed.size());
+	QByteArray ret;
+	ret.reserve(4 + compressed.size());
+
+	return ret.append((char *)&lzsSize, 4).append(compressed);
+}
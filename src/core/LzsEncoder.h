@@ -1,39 +1,40 @@
-/****************************************************************************
- ** Makou Reactor Final Fantasy VII Field Script Editor
- ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
- **
- ** This program is free software: you can redistribute it and/or modify
- ** it under the terms of the GNU General Public License as published by
- ** the Free Software Foundation, either version 3 of the License, or
- ** (at your option) any later version.
- **
- ** This program is distributed in the hope that it will be useful,
- ** but WITHOUT ANY WARRANTY; without even the implied warranty of
- ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- ** GNU General Public License for more details.
- **
- ** You should have received a copy of the GNU General Public License
- ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
- ****************************************************************************/
-#pragma once
-
-#include <QtCore>
-
-class Field;
-
-class FieldSaveIO : public QIODevice
-{
-	Q_OBJECT
-public:
-	FieldSaveIO(Field *field, QObject *parent = nullptr);
-	virtual bool open(OpenMode mode) override;
-	virtual void close() override;
-	virtual qint64 size() const override;
-protected:
-	virtual qint64 readData(char *data, qint64 maxSize) override;
-private:
-	qint64 writeData(const char *, qint64) override { return -1; }
-	bool setCache();
-	Field *_field;
-	QByteArray _cache;
-};
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+
+/*
+ * Reentrant LZS compressor, with a hash chain match finder
+ * over the 4 KiB window.
+ * The output can be decompressed with LZS::decompress or LzsDecoder.
+ */
+class LzsEncoder
+{
+public:
+	enum Level {
+		Fast, Default, MaxRatio
+	};
+
+	static QByteArray compress(const char *data, qsizetype size, Level level = Default);
+	static inline QByteArray compress(const QByteArray &data, Level level = Default) {
+		return compress(data.constData(), data.size(), level);
+	}
+	// With the 4-byte LZS size header
+	static QByteArray compressWithHeader(const QByteArray &data, Level level = Default);
+};
@@ -0,0 +1,52 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+
+/*
+ * Read-only memory mapping of a file.
+ * The data is returned as views (QByteArray::fromRawData),
+ * they must not be used after close().
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const QString &fileName);
+	void close();
+	inline bool isOpen() const {
+		return _data != nullptr;
+	}
+	inline qint64 size() const {
+		return _size;
+	}
+	// size < 0 means up to the end, null if out of range
+	QByteArray data(qint64 position = 0, qint64 size = -1) const;
+	inline const uchar *constData() const {
+		return _data;
+	}
+private:
+	Q_DISABLE_COPY(MappedFile)
+
+	QFile _file;
+	uchar *_data;
+	qint64 _size;
+};
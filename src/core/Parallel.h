@@ -0,0 +1,125 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+
+namespace Parallel {
+
+/*
+ * Number of threads to use when the user asks for jobs threads,
+ * 0 or less meaning one thread per core.
+ */
+inline int jobCount(int jobs)
+{
+	return jobs > 0 ? jobs : qMax(1, QThread::idealThreadCount());
+}
+
+/*
+ * Calls work(i) for every i in [0, count) on up to jobs threads,
+ * then collect(i) on the calling thread in ascending order, as soon as
+ * work(0)...work(i) are done.
+ * Workers never run more than window items ahead of the last collected
+ * one, this bounds the memory used by the pending results.
+ * If collect() returns false, no more work is started and false is
+ * returned once the running items are finished.
+ * With one job, everything is run on the calling thread.
+ */
+template<typename Work, typename Collect>
+bool orderedFor(qsizetype count, int jobs, Work work, Collect collect,
+                qsizetype window = 0)
+{
+	jobs = int(qMin(qsizetype(jobCount(jobs)), count));
+
+	if (jobs <= 1) {
+		for (qsizetype i = 0; i < count; ++i) {
+			work(i);
+			if (!collect(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	if (window <= 0) {
+		window = qsizetype(jobs) * 4;
+	}
+
+	QMutex mutex;
+	QWaitCondition itemDone, itemCollected;
+	QList<bool> done(count, false);
+	qsizetype next = 0, collected = 0;
+	bool canceled = false;
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(jobs);
+
+	for (int job = 0; job < jobs; ++job) {
+		pool.start([&]() {
+			forever {
+				qsizetype i;
+
+				{
+					QMutexLocker locker(&mutex);
+					while (!canceled && next < count && next >= collected + window) {
+						itemCollected.wait(&mutex);
+					}
+					if (canceled || next >= count) {
+						return;
+					}
+					i = next++;
+				}
+
+				work(i);
+
+				QMutexLocker locker(&mutex);
+				done[i] = true;
+				itemDone.wakeAll();
+			}
+		});
+	}
+
+	bool ok = true;
+
+	for (qsizetype i = 0; i < count; ++i) {
+		{
+			QMutexLocker locker(&mutex);
+			while (!done.at(i)) {
+				itemDone.wait(&mutex);
+			}
+		}
+
+		ok = collect(i);
+
+		QMutexLocker locker(&mutex);
+		collected = i + 1;
+		if (!ok) {
+			canceled = true;
+		}
+		itemCollected.wakeAll();
+		if (!ok) {
+			break;
+		}
+	}
+
+	pool.waitForDone();
+
+	return ok;
+}
+
+}
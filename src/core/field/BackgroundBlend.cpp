@@ -0,0 +1,177 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "BackgroundBlend.h"
+#include "BackgroundFile.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BACKGROUND_BLEND_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BACKGROUND_BLEND_AVX2_TARGET
+#else
+#define BACKGROUND_BLEND_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+static void blendRowScalar(quint8 type, QRgb *dst, const QRgb *src,
+                           const quint32 *mask, int count)
+{
+	for (int i = 0; i < count; ++i) {
+		if (mask[i]) {
+			dst[i] = BackgroundFile::blendColor(type, dst[i], src[i]);
+		}
+	}
+}
+
+#ifdef BACKGROUND_BLEND_X86
+
+static inline __m128i blend4SSE2(quint8 type, __m128i color0, __m128i color1)
+{
+	switch (type) {
+	case 1:
+		return _mm_adds_epu8(color0, color1);
+	case 2:
+		return _mm_subs_epu8(color0, color1);
+	case 3:
+		return _mm_adds_epu8(color0, _mm_and_si128(_mm_srli_epi16(color1, 2),
+		                                           _mm_set1_epi8(0x3F)));
+	default: // Rounded down average
+		return _mm_add_epi8(_mm_and_si128(color0, color1),
+		                    _mm_and_si128(_mm_srli_epi16(_mm_xor_si128(color0, color1), 1),
+		                                  _mm_set1_epi8(0x7F)));
+	}
+}
+
+static void blendRowSSE2(quint8 type, QRgb *dst, const QRgb *src,
+                         const quint32 *mask, int count)
+{
+	const __m128i alpha = _mm_set1_epi32(int(0xFF000000));
+	int i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i color0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i)),
+		        color1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)),
+		        m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i));
+		__m128i blended = _mm_or_si128(blend4SSE2(type, color0, color1), alpha);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+		                 _mm_or_si128(_mm_and_si128(m, blended), _mm_andnot_si128(m, color0)));
+	}
+
+	blendRowScalar(type, dst + i, src + i, mask + i, count - i);
+}
+
+BACKGROUND_BLEND_AVX2_TARGET
+static inline __m256i blend8AVX2(quint8 type, __m256i color0, __m256i color1)
+{
+	switch (type) {
+	case 1:
+		return _mm256_adds_epu8(color0, color1);
+	case 2:
+		return _mm256_subs_epu8(color0, color1);
+	case 3:
+		return _mm256_adds_epu8(color0, _mm256_and_si256(_mm256_srli_epi16(color1, 2),
+		                                                 _mm256_set1_epi8(0x3F)));
+	default: // Rounded down average
+		return _mm256_add_epi8(_mm256_and_si256(color0, color1),
+		                       _mm256_and_si256(_mm256_srli_epi16(_mm256_xor_si256(color0, color1), 1),
+		                                        _mm256_set1_epi8(0x7F)));
+	}
+}
+
+BACKGROUND_BLEND_AVX2_TARGET
+static void blendRowAVX2(quint8 type, QRgb *dst, const QRgb *src,
+                         const quint32 *mask, int count)
+{
+	const __m256i alpha = _mm256_set1_epi32(int(0xFF000000));
+	int i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256i color0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i)),
+		        color1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)),
+		        m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + i));
+		__m256i blended = _mm256_or_si256(blend8AVX2(type, color0, color1), alpha);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+		                    _mm256_blendv_epi8(color0, blended, m));
+	}
+
+	blendRowSSE2(type, dst + i, src + i, mask + i, count - i);
+}
+
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	// OSXSAVE and AVX, then check that the OS saves the YMM registers
+	if ((info[2] & 0x18000000) != 0x18000000 || (_xgetbv(0) & 0x6) != 0x6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & 0x20) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static BackgroundBlend::Implementation detectImplementation()
+{
+#ifdef BACKGROUND_BLEND_X86
+	return cpuHasAVX2() ? BackgroundBlend::AVX2 : BackgroundBlend::SSE2;
+#else
+	return BackgroundBlend::Scalar;
+#endif
+}
+
+static BackgroundBlend::Implementation currentImplementation = detectImplementation();
+
+void BackgroundBlend::blendRow(quint8 type, QRgb *dst, const QRgb *src,
+                               const quint32 *mask, int count)
+{
+	switch (currentImplementation) {
+#ifdef BACKGROUND_BLEND_X86
+	case AVX2:
+		blendRowAVX2(type, dst, src, mask, count);
+		break;
+	case SSE2:
+		blendRowSSE2(type, dst, src, mask, count);
+		break;
+#endif
+	default:
+		blendRowScalar(type, dst, src, mask, count);
+		break;
+	}
+}
+
+BackgroundBlend::Implementation BackgroundBlend::implementation()
+{
+	return currentImplementation;
+}
+
+void BackgroundBlend::setImplementation(Implementation implementation)
+{
+	// Never select an implementation unsupported by the CPU
+	currentImplementation = qMin(implementation, detectImplementation());
+}
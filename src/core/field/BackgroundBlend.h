@@ -0,0 +1,42 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include <QRgb>
+
+/*
+ * Row versions of BackgroundFile::blendColor, for the four PSX
+ * transparency modes. The implementation (AVX2, SSE2 or scalar)
+ * is chosen at runtime according to the CPU.
+ */
+class BackgroundBlend
+{
+public:
+	enum Implementation {
+		Scalar, SSE2, AVX2
+	};
+
+	// dst[i] = blendColor(type, dst[i], src[i]) when mask[i] is 0xFFFFFFFF,
+	// dst[i] is left untouched when mask[i] is 0
+	static void blendRow(quint8 type, QRgb *dst, const QRgb *src,
+	                     const quint32 *mask, int count);
+	static Implementation implementation();
+	// For comparisons only, not thread-safe
+	static void setImplementation(Implementation implementation);
+};
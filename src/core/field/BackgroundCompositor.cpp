@@ -0,0 +1,284 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "BackgroundCompositor.h"
+#include "BackgroundFile.h"
+
+BackgroundCompositor::BackgroundCompositor(BackgroundFile *background) :
+    _background(background), _hasParamActifs(false), _hasIDs(false),
+    _hasTileIds(false), _onlyParams(false), _transparent(false), _warning(false)
+{
+	_z[0] = _z[1] = -1;
+	_layers[0] = _layers[1] = _layers[2] = _layers[3] = true;
+}
+
+void BackgroundCompositor::setBackground(BackgroundFile *background)
+{
+	if (_background != background) {
+		_background = background;
+		invalidate();
+	}
+}
+
+void BackgroundCompositor::setFilter(const QHash<quint8, quint8> *paramActifs, const qint16 *z,
+                                     const bool *layers, const QSet<quint16> *IDs,
+                                     const QList<quint16> *tileIds, bool onlyParams)
+{
+	_hasParamActifs = paramActifs != nullptr;
+	_paramActifs = _hasParamActifs ? *paramActifs : QHash<quint8, quint8>();
+	_z[0] = z != nullptr ? z[0] : -1;
+	_z[1] = z != nullptr ? z[1] : -1;
+	for (int i = 0; i < 4; ++i) {
+		_layers[i] = layers == nullptr || layers[i];
+	}
+	_hasIDs = IDs != nullptr;
+	_IDs = _hasIDs ? *IDs : QSet<quint16>();
+	_hasTileIds = tileIds != nullptr;
+	_tileIds = _hasTileIds ? *tileIds : QList<quint16>();
+	_onlyParams = onlyParams;
+}
+
+void BackgroundCompositor::setTransparent(bool transparent)
+{
+	if (_transparent != transparent) {
+		_transparent = transparent;
+		invalidate();
+	}
+}
+
+void BackgroundCompositor::invalidate()
+{
+	_image = QImage();
+	_drawn.clear();
+	_pendingDirty = QRegion();
+	_warning = false;
+}
+
+void BackgroundCompositor::invalidate(const QList<Tile> &tiles)
+{
+	if (_image.isNull()) {
+		return;
+	}
+
+	for (const Tile &tile : tiles) {
+		const QRect source(tile.srcX, tile.srcY, tile.size, tile.size);
+
+		_pendingDirty += tileRect(tile);
+
+		for (const Tile &drawn : qAsConst(_drawn)) {
+			if (drawn.textureID == tile.textureID && drawn.textureY == tile.textureY
+			        && source.intersects(QRect(drawn.srcX, drawn.srcY, drawn.size, drawn.size))) {
+				_pendingDirty += tileRect(drawn);
+			}
+		}
+	}
+}
+
+bool BackgroundCompositor::accept(const Tile &tile) const
+{
+	if (tile.layerID >= 4 || !_layers[tile.layerID] || (_hasIDs && !_IDs.contains(tile.ID))) {
+		return false;
+	}
+
+	if (tile.layerID == 0) {
+		return true;
+	}
+
+	return ((!_onlyParams && tile.state == 0) || !_hasParamActifs || (_paramActifs.value(tile.param, 0) & tile.state))
+	        && (!_hasTileIds || _tileIds.contains(tile.tileID));
+}
+
+qint32 BackgroundCompositor::sortKey(const Tile &tile) const
+{
+	if (tile.layerID <= 1) {
+		return 4096 - tile.ID;
+	}
+
+	const qint16 z = _z[tile.layerID - 2];
+
+	return 4096 - (z != -1 ? z : tile.ID);
+}
+
+QImage BackgroundCompositor::image(bool *warning)
+{
+	if (warning) {
+		*warning = false;
+	}
+
+	if (_background == nullptr || (!_background->isOpen() && !_background->open())
+	        || _background->textures() == nullptr) {
+		invalidate();
+		return QImage();
+	}
+
+	// Same order as the QMultiMap built by BackgroundTiles::filter():
+	// by key, the last inserted first for the same key
+	const BackgroundTileStore &store = _background->tileStore();
+	QList<std::pair<qint32, qint32>> order;
+	order.reserve(store.size());
+
+	for (quint32 position = 0; position < quint32(store.size()); ++position) {
+		const Tile &tile = store.tile(position);
+		if (accept(tile)) {
+			order.append(std::make_pair(sortKey(tile), -qint32(position)));
+		}
+	}
+
+	std::sort(order.begin(), order.end());
+
+	QList<Tile> tiles;
+	tiles.reserve(order.size());
+
+	for (const std::pair<qint32, qint32> &entry : qAsConst(order)) {
+		tiles.append(store.tile(quint32(-entry.second)));
+	}
+
+	if (tiles.isEmpty()) {
+		invalidate();
+		return QImage();
+	}
+
+	const QRect area = _area.isNull() ? _background->tiles().rect() : _area;
+	std::vector<QRgb> colors;
+	std::vector<quint32> masks;
+	_background->paletteTables(colors, masks);
+
+	if (_image.isNull() || area != _imageArea) {
+		_image = QImage(area.size(), QImage::Format_ARGB32);
+		_imageArea = area;
+		_warning = false;
+		draw(tiles, _image.rect(), colors, masks);
+	} else {
+		const QRegion dirty = (dirtyRegion(tiles) + _pendingDirty) & _image.rect();
+
+		for (const QRect &rect : dirty) {
+			draw(tiles, rect, colors, masks);
+		}
+	}
+
+	_pendingDirty = QRegion();
+
+	_drawn = tiles;
+
+	if (warning) {
+		*warning = _warning;
+	}
+
+	return _image;
+}
+
+QRegion BackgroundCompositor::dirtyRegion(const QList<Tile> &tiles) const
+{
+	QHash<quint32, qsizetype> drawnIndexes;
+	drawnIndexes.reserve(_drawn.size());
+
+	for (qsizetype i = 0; i < _drawn.size(); ++i) {
+		if (drawnIndexes.contains(identity(_drawn.at(i)))) {
+			return QRegion(_image.rect());
+		}
+		drawnIndexes.insert(identity(_drawn.at(i)), i);
+	}
+
+	QRegion dirty;
+	// (index in tiles, index in _drawn) of the unchanged tiles
+	QList<std::pair<qsizetype, qsizetype>> kept;
+	QBitArray matched(_drawn.size());
+
+	for (qsizetype i = 0; i < tiles.size(); ++i) {
+		const Tile &tile = tiles.at(i);
+		auto it = drawnIndexes.constFind(identity(tile));
+
+		if (it != drawnIndexes.constEnd() && !matched.testBit(*it)
+		        && sameDrawing(_drawn.at(*it), tile)) {
+			matched.setBit(*it);
+			kept.append(std::make_pair(i, *it));
+		} else {
+			dirty += tileRect(tile);
+		}
+	}
+
+	for (qsizetype i = 0; i < _drawn.size(); ++i) {
+		if (!matched.testBit(i)) {
+			dirty += tileRect(_drawn.at(i));
+		}
+	}
+
+	// The longest run of unchanged tiles in the same relative order is not redrawn
+	std::vector<qsizetype> tails, previous(size_t(kept.size()), -1);
+
+	for (qsizetype k = 0; k < kept.size(); ++k) {
+		auto it = std::lower_bound(tails.begin(), tails.end(), kept.at(k).second,
+		                           [&](qsizetype tail, qsizetype drawnIndex) {
+			return kept.at(tail).second < drawnIndex;
+		});
+		if (it != tails.begin()) {
+			previous[size_t(k)] = *(it - 1);
+		}
+		if (it == tails.end()) {
+			tails.push_back(k);
+		} else {
+			*it = k;
+		}
+	}
+
+	std::vector<bool> ordered(size_t(kept.size()), false);
+
+	for (qsizetype k = tails.empty() ? -1 : tails.back(); k >= 0; k = previous[size_t(k)]) {
+		ordered[size_t(k)] = true;
+	}
+
+	for (qsizetype k = 0; k < kept.size(); ++k) {
+		if (!ordered[size_t(k)]) {
+			dirty += tileRect(tiles.at(kept.at(k).first));
+		}
+	}
+
+	return dirty;
+}
+
+void BackgroundCompositor::draw(const QList<Tile> &tiles, const QRect &clip,
+                                const std::vector<QRgb> &colors, const std::vector<quint32> &masks)
+{
+	QRgb *pixels = reinterpret_cast<QRgb *>(_image.bits());
+	const int width = _image.width();
+	const QRgb fillColor = _transparent ? 0 : 0xFF000000;
+
+	for (int y = clip.top(); y <= clip.bottom(); ++y) {
+		QRgb *line = pixels + y * width;
+		std::fill(line + clip.left(), line + clip.right() + 1, fillColor);
+	}
+
+	QList<const Tile *> visibleTiles;
+
+	for (const Tile &tile : tiles) {
+		if (tileRect(tile).intersects(clip)) {
+			visibleTiles.append(&tile);
+		}
+	}
+
+	_background->drawTiles(visibleTiles, pixels, _imageArea, clip, colors.data(), masks.data(), 0, _warning);
+}
+
+bool BackgroundCompositor::sameDrawing(const Tile &tile, const Tile &other)
+{
+	return tile.dstX == other.dstX && tile.dstY == other.dstY
+	        && tile.srcX == other.srcX && tile.srcY == other.srcY
+	        && tile.paletteID == other.paletteID && tile.blending == other.blending
+	        && tile.typeTrans == other.typeTrans && tile.size == other.size
+	        && tile.textureID == other.textureID && tile.textureY == other.textureY
+	        && tile.depth == other.depth;
+}
@@ -0,0 +1,85 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include <QImage>
+#include <QRegion>
+#include "BackgroundTiles.h"
+
+class BackgroundFile;
+
+/*
+ * Flattened image of a background, kept between calls to image():
+ * when the filter or the tiles change, only the pixels covered by
+ * the tiles that appear, disappear, move, change or are reordered
+ * are drawn again, in the order of BackgroundFile::openBackground().
+ * Call invalidate() after a palette or texture modification.
+ */
+class BackgroundCompositor
+{
+public:
+	explicit BackgroundCompositor(BackgroundFile *background = nullptr);
+
+	void setBackground(BackgroundFile *background);
+	inline BackgroundFile *background() const {
+		return _background;
+	}
+	// Same as BackgroundTiles::filter(), the data is copied
+	void setFilter(const QHash<quint8, quint8> *paramActifs, const qint16 *z,
+	               const bool *layers, const QSet<quint16> *IDs,
+	               const QList<quint16> *tileIds = nullptr, bool onlyParams = false);
+	// Background rect drawn, the rect of every tile when null
+	inline void setArea(const QRect &area) {
+		_area = area;
+	}
+	void setTransparent(bool transparent);
+	void invalidate();
+	// The texture data of these tiles changed: the tiles using the same
+	// texture area are drawn again
+	void invalidate(const QList<Tile> &tiles);
+	QImage image(bool *warning = nullptr);
+private:
+	bool accept(const Tile &tile) const;
+	qint32 sortKey(const Tile &tile) const;
+	QRegion dirtyRegion(const QList<Tile> &tiles) const;
+	void draw(const QList<Tile> &tiles, const QRect &clip,
+	          const std::vector<QRgb> &colors, const std::vector<quint32> &masks);
+	inline QRect tileRect(const Tile &tile) const {
+		return QRect(_imageArea.x() + tile.dstX, _imageArea.y() + tile.dstY, tile.size, tile.size);
+	}
+	inline static quint32 identity(const Tile &tile) {
+		return (quint32(tile.layerID) << 16) | tile.tileID;
+	}
+	static bool sameDrawing(const Tile &tile, const Tile &other);
+
+	BackgroundFile *_background;
+	QHash<quint8, quint8> _paramActifs;
+	QSet<quint16> _IDs;
+	QList<quint16> _tileIds;
+	QRect _area;
+	qint16 _z[2];
+	bool _layers[4];
+	bool _hasParamActifs, _hasIDs, _hasTileIds, _onlyParams, _transparent;
+
+	QImage _image;
+	QRect _imageArea;
+	QList<Tile> _drawn; // In drawing order
+	QRegion _pendingDirty;
+	bool _warning;
+};
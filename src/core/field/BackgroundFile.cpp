@@ -16,15 +16,17 @@
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
 #include "BackgroundFile.h"
+#include "BackgroundBlend.h"
 #include "Field.h"
+#include "core/Parallel.h"
 
 BackgroundFile::BackgroundFile(Field *field) :
-	FieldPart(field), _textures(nullptr)
+	FieldPart(field), _tileStore(nullptr), _textures(nullptr)
 {
 }
 
 BackgroundFile::BackgroundFile(const BackgroundFile &other) :
-	FieldPart(other.field()), _textures(nullptr)
+	FieldPart(other.field()), _tileStore(nullptr), _textures(nullptr)
 {
 	setTiles(other.tiles());
 }
@@ -35,6 +37,7 @@ BackgroundFile::~BackgroundFile()
 	if (_textures) {
 		delete _textures;
 	}
+	delete _tileStore;
 }
 
 void BackgroundFile::clear()
@@ -46,6 +49,22 @@ void BackgroundFile::clear()
 		_textures = nullptr;
 	}
 	_tiles.clear();
+	invalidateTileStore();
+}
+
+const BackgroundTileStore &BackgroundFile::tileStore() const
+{
+	if (_tileStore == nullptr) {
+		_tileStore = new BackgroundTileStore(_tiles);
+	}
+
+	return *_tileStore;
+}
+
+void BackgroundFile::invalidateTileStore()
+{
+	delete _tileStore;
+	_tileStore = nullptr;
 }
 
 void BackgroundFile::initEmpty()
@@ -53,23 +72,23 @@ void BackgroundFile::initEmpty()
 
 }
 
-QImage BackgroundFile::openBackground(bool transparent, bool *warning)
+QImage BackgroundFile::openBackground(bool transparent, bool *warning, int jobs)
 {
 	// Search default background params
 	QHash<quint8, quint8> paramActifs;
 	qint16 z[] = {-1, -1};
 	field()->scriptsAndTexts()->bgParamAndBgMove(paramActifs, z);
-	return openBackground(&paramActifs, z, nullptr, nullptr, false, transparent, warning);
+	return openBackground(&paramActifs, z, nullptr, nullptr, false, transparent, warning, jobs);
 }
 
 QImage BackgroundFile::openBackground(const QHash<quint8, quint8> *paramActifs, const qint16 *z,
                                       const bool *layers, const QSet<quint16> *IDs, bool onlyParams,
-                                      bool transparent, bool *warning)
+                                      bool transparent, bool *warning, int jobs)
 {
-	return openBackground(tiles().filter(paramActifs, z, layers, IDs, nullptr, onlyParams), _tiles.rect(), transparent, warning);
+	return openBackground(tiles().filter(paramActifs, z, layers, IDs, nullptr, onlyParams), _tiles.rect(), transparent, warning, jobs);
 }
 
-QImage BackgroundFile::openBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent, bool *warning)
+QImage BackgroundFile::openBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent, bool *warning, int jobs)
 {
 	if (!isOpen() && !open()) {
 		if (warning) {
@@ -78,10 +97,64 @@ QImage BackgroundFile::openBackground(const BackgroundTiles &tiles, const QRect
 		return QImage();
 	}
 
-	return drawBackground(tiles, area, transparent, warning);
+	return drawBackground(tiles, area, transparent, warning, jobs);
+}
+
+template<int depth>
+static inline quint8 paletteIndex(const uchar *src, int x)
+{
+	return depth == 0 ? (src[x / 2] >> ((x & 1) * 4)) & 0xF : src[x];
+}
+
+template<int depth>
+static inline void drawPalettedRow(QRgb *line, const uchar *src, int from, int to,
+                                   const QRgb *colors, const quint32 *masks)
+{
+	for (int x = from; x < to; ++x) {
+		const quint8 index = paletteIndex<depth>(src, x);
+		if (masks[index]) {
+			line[x] = colors[index];
+		}
+	}
+}
+
+template<int depth>
+static inline void blendPalettedRow(QRgb *line, const uchar *src, int from, int to,
+                                    const QRgb *colors, const quint32 *masks,
+                                    quint8 typeTrans)
+{
+	QRgb row[256];
+	quint32 rowMasks[256];
+
+	for (int x = from; x < to; ++x) {
+		const quint8 index = paletteIndex<depth>(src, x);
+		row[x] = colors[index];
+		rowMasks[x] = masks[index];
+	}
+
+	BackgroundBlend::blendRow(typeTrans, line + from, row + from, rowMasks + from, to - from);
+}
+
+QImage BackgroundFile::drawBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent, bool *warning, int jobs) const
+{
+	if (tiles.isEmpty() || _textures == nullptr) {
+		if (warning) {
+			*warning = false;
+		}
+		return QImage();
+	}
+
+	// Palettes are resolved once, pixels are written straight from the texture data
+	std::vector<QRgb> colors;
+	std::vector<quint32> masks;
+	paletteTables(colors, masks);
+
+	return drawBackground(tiles, area, colors, masks, transparent, warning, jobs);
 }
 
-QImage BackgroundFile::drawBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent, bool *warning) const
+QImage BackgroundFile::drawBackground(const BackgroundTiles &tiles, const QRect &area,
+                                      const std::vector<QRgb> &colors, const std::vector<quint32> &masks,
+                                      bool transparent, bool *warning, int jobs) const
 {
 	if (tiles.isEmpty() || _textures == nullptr) {
 		if (warning) {
@@ -96,70 +169,177 @@ QImage BackgroundFile::drawBackground(const BackgroundTiles &tiles, const QRect
 	QRgb *pixels = reinterpret_cast<QRgb *>(image.bits());
 	bool warned = false; // To prevent verbosity of warnings
 
+	QList<const Tile *> orderedTiles;
+	orderedTiles.reserve(tiles.size());
 	for (const Tile &tile : tiles) {
-		QList<uint> indexOrColorList = _textures->tile(tile);
+		orderedTiles.append(&tile);
+	}
 
-		if (indexOrColorList.isEmpty()) {
-			if (!warned) {
-				qWarning() << "Texture ID overflow" << tile.textureID;
-				warned = true;
-			}
+	drawTiles(orderedTiles, pixels, area, image.rect(), colors.data(), masks.data(), jobs, warned);
+
+	if (warning) {
+		*warning = warned;
+	}
+
+	return image;
+}
+
+void BackgroundFile::paletteTables(std::vector<QRgb> &colors, std::vector<quint32> &masks) const
+{
+	colors.assign(size_t(_palettes.size()) * 256, 0);
+	masks.assign(size_t(_palettes.size()) * 256, 0);
+
+	for (qsizetype palID = 0; palID < _palettes.size(); ++palID) {
+		const Palette *palette = _palettes.at(palID);
+		memcpy(colors.data() + palID * 256, palette->colorTable(), 256 * sizeof(QRgb));
+		memcpy(masks.data() + palID * 256, palette->maskTable(), 256 * sizeof(quint32));
+	}
+}
+
+void BackgroundFile::drawTiles(const QList<const Tile *> &tiles, QRgb *pixels, const QRect &area, const QRect &clip,
+                               const QRgb *colors, const quint32 *masks, int jobs, bool &warned) const
+{
+	const int bandHeight = 16, minBandCount = 4;
+	const int bandCount = (clip.height() + bandHeight - 1) / bandHeight;
+
+	if (bandCount < minBandCount || Parallel::jobCount(jobs) <= 1) {
+		for (const Tile *tile : tiles) {
+			drawTile(*tile, pixels, area, clip, colors, masks, warned);
+		}
+		return;
+	}
+
+	// Bands are disjoint, in each band the tiles are drawn in the same order
+	// as the serial path, so the blending gives exactly the same pixels
+	std::vector<std::vector<const Tile *>> bands(size_t(bandCount));
+
+	for (const Tile *tile : tiles) {
+		const int top = area.y() + tile->dstY - clip.top(),
+		        first = qMax(0, top) / bandHeight,
+		        last = qMin(clip.height() - 1, top + tile->size - 1);
+
+		if (last < 0 || area.x() + tile->dstX > clip.right() || area.x() + tile->dstX + tile->size <= clip.left()) {
 			continue;
 		}
 
-		quint8 depth = _textures->depth(tile);
-		Palette *palette = nullptr;
+		for (int band = first; band <= last / bandHeight; ++band) {
+			bands[size_t(band)].push_back(tile);
+		}
+	}
 
-		if (depth <= 1) {
-			if (tile.paletteID >= _palettes.size()) {
-				if (!warned) {
-					qWarning() << "Palette ID overflow" << tile.paletteID << _palettes.size();
-					warned = true;
-				}
-				continue;
-			}
-			palette = _palettes.at(tile.paletteID);
-		} else if (depth != 2) {
+	std::vector<char> bandWarned(size_t(bandCount), false);
+
+	Parallel::orderedFor(bandCount, jobs, [&](qsizetype band) {
+		const QRect bandClip = clip.intersected(QRect(clip.left(), clip.top() + int(band) * bandHeight,
+		                                              clip.width(), bandHeight));
+		bool bandWarning = false;
+
+		for (const Tile *tile : bands[size_t(band)]) {
+			drawTile(*tile, pixels, area, bandClip, colors, masks, bandWarning);
+		}
+
+		bandWarned[size_t(band)] = bandWarning;
+	}, [&](qsizetype band) {
+		warned = warned || bandWarned[size_t(band)];
+		return true;
+	});
+}
+
+void BackgroundFile::drawTile(const Tile &tile, QRgb *pixels, const QRect &area, const QRect &clip,
+                              const QRgb *colors, const quint32 *masks, bool &warned) const
+{
+	int texWidth = 0, lastByte = 0;
+	int origin = _textures->tileOrigin(tile, texWidth, lastByte);
+
+	if (origin < 0 || origin >= lastByte) {
+		if (!warned) {
+			qWarning() << "Texture ID overflow" << tile.textureID;
+			warned = true;
+		}
+		return;
+	}
+
+	quint8 depth = _textures->depth(tile);
+	const QRgb *palColors = nullptr;
+	const quint32 *palMasks = nullptr;
+
+	if (depth <= 1) {
+		if (tile.paletteID >= _palettes.size()) {
 			if (!warned) {
-				qWarning() << "Unknown depth" << _textures->depth(tile);
+				qWarning() << "Palette ID overflow" << tile.paletteID << _palettes.size();
 				warned = true;
 			}
-			continue;
+			return;
+		}
+		palColors = colors + size_t(tile.paletteID) * 256;
+		palMasks = masks + size_t(tile.paletteID) * 256;
+	} else if (depth != 2) {
+		if (!warned) {
+			qWarning() << "Unknown depth" << depth;
+			warned = true;
 		}
+		return;
+	}
 
-		quint8 right = 0;
-		qint32 top = (area.y() + tile.dstY) * area.width();
-		qint32 baseX = area.x() + tile.dstX;
+	// Position of the tile in the image, and visible columns
+	const int left = area.x() + tile.dstX, top = area.y() + tile.dstY,
+	        from = qMax(0, clip.left() - left),
+	        to = qMin(int(tile.size), clip.right() + 1 - left);
 
-		for (uint indexOrColor : qAsConst(indexOrColorList)) {
-			if (palette == nullptr) {
-				if (indexOrColor != 0) {
-					pixels[baseX + right + top] = qRgb(qRed(indexOrColor), qGreen(indexOrColor), qBlue(indexOrColor));
-				}
-			} else {
-				if (palette->notZero(quint8(indexOrColor))) {
-					if (tile.blending) {
-						pixels[baseX + right + top] = blendColor(tile.typeTrans,
-						                                         pixels[baseX + right + top],
-						                                         palette->color(quint8(indexOrColor)));
-					} else {
-						pixels[baseX + right + top] = palette->color(quint8(indexOrColor));
+	if (from >= to || top > clip.bottom() || top + tile.size <= clip.top()) {
+		return;
+	}
+
+	const int width = area.width();
+	const uchar *data = reinterpret_cast<const uchar *>(_textures->data().constData());
+	const uchar *src = data + origin;
+	const uchar *end = data + lastByte;
+	QRgb *line = pixels + top * width + left;
+
+	for (int y = 0; y < tile.size; ++y, src += texWidth, line += width) {
+		qsizetype available = end - src;
+		if (available <= 0) {
+			break;
+		}
+		// Pixels available in this row
+		if (depth == 0) {
+			available *= 2;
+		} else if (depth == 2) {
+			available = (available + 1) / 2;
+		}
+		const int count = int(qMin(available, qsizetype(tile.size)));
+
+		if (top + y >= clip.top() && top + y <= clip.bottom()) {
+			const int rowTo = qMin(count, to);
+
+			if (from >= rowTo) {
+				// Nothing visible
+			} else if (depth == 2) {
+				QRgb row[256];
+				_textures->directColors(src, from, rowTo, row);
+
+				for (int x = from; x < rowTo; ++x) {
+					if (row[x] != 0) {
+						line[x] = row[x] | 0xFF000000;
 					}
 				}
-			}
-
-			if (++right == tile.size) {
-				right = 0;
-				top += area.width();
+			} else if (depth == 1) {
+				if (tile.blending) {
+					blendPalettedRow<1>(line, src, from, rowTo, palColors, palMasks, tile.typeTrans);
+				} else {
+					drawPalettedRow<1>(line, src, from, rowTo, palColors, palMasks);
+				}
+			} else if (tile.blending) {
+				blendPalettedRow<0>(line, src, from, rowTo, palColors, palMasks, tile.typeTrans);
+			} else {
+				drawPalettedRow<0>(line, src, from, rowTo, palColors, palMasks);
 			}
 		}
-	}
 
-	if (warning) {
-		*warning = warned;
+		if (count < tile.size) {
+			break;
+		}
 	}
-
-	return image;
 }
 
 bool BackgroundFile::usedParams(QMap<LayerParam, quint8> &usedParams, bool *layerExists, QSet<quint16> *usedIDs, QList<QList<quint16> > *effectLayers)
@@ -233,7 +413,7 @@ bool BackgroundFile::exportTiles(const QString &fileName, const BackgroundTiles
 	return drawBackground(tiles, _tiles.rect()).save(fileName);
 }
 
-bool BackgroundFile::exportLayers(const QString &dirPath, const QString &extension) const
+bool BackgroundFile::exportLayers(const QString &dirPath, const QString &extension, int jobs) const
 {
 	QDir dir(dirPath);
 
@@ -241,10 +421,33 @@ bool BackgroundFile::exportLayers(const QString &dirPath, const QString &extensi
 		dir.mkpath("./");
 	}
 
+	const QList<std::pair<QString, QImage>> images = layerImages(extension, jobs);
+
+	for (const std::pair<QString, QImage> &image : images) {
+		image.second.save(dir.filePath(image.first));
+	}
+
+	return true;
+}
+
+QList<std::pair<QString, QImage>> BackgroundFile::layerImages(const QString &extension, int jobs) const
+{
+	QList<std::pair<QString, QImage>> images;
+
+	if (_textures == nullptr) {
+		return images;
+	}
+
 	bool layerExists[3];
 	QSet<quint16> usedIDs;
 	tiles().usedParams(layerExists, &usedIDs);
 
+	const BackgroundTileStore &store = tileStore();
+	const QRect area = _tiles.rect();
+	std::vector<QRgb> colors;
+	std::vector<quint32> masks;
+	paletteTables(colors, masks);
+
 	for (quint8 i = 0 ; i < 4; ++i) {
 		if (i == 0 || layerExists[i - 1]) {
 			QString fileName = QString("%1_%2_%3." % extension)
@@ -252,15 +455,21 @@ bool BackgroundFile::exportLayers(const QString &dirPath, const QString &extensi
 			                       .arg(i == 0 ? 0 : i - 1);
 			if (i == 1) {
 				for (quint16 ID: qAsConst(usedIDs)) {
-					exportTiles(dir.filePath(fileName.arg(ID)), tiles().tilesByID(ID));
+					QImage image = drawBackground(store.tiles(store.byID(ID)), area, colors, masks, false, nullptr, jobs);
+					if (!image.isNull()) {
+						images.append(std::make_pair(fileName.arg(ID), image));
+					}
 				}
 			} else {
-				exportTiles(dir.filePath(fileName.arg(42)), tiles().tiles(i));
+				QImage image = drawBackground(store.tiles(store.layer(i)), area, colors, masks, false, nullptr, jobs);
+				if (!image.isNull()) {
+					images.append(std::make_pair(fileName.arg(42), image));
+				}
 			}
 		}
 	}
 
-	return true;
+	return images;
 }
 
 bool BackgroundFile::addPalette(const char *data)
@@ -280,6 +489,7 @@ void BackgroundFile::removePalette(qsizetype palID)
 {
 	delete _palettes.takeAt(palID);
 	_tiles.shiftPalettes(palID, -1);
+	invalidateTileStore();
 
 	setModified(true);
 }
@@ -288,6 +498,7 @@ void BackgroundFile::setZLayer1(quint16 oldZ, quint16 newZ)
 {
 	if (oldZ != newZ) {
 		_tiles.setZLayer1(oldZ, newZ);
+		invalidateTileStore();
 	
 		setModified(field()->isPC());
 	}
@@ -300,6 +511,7 @@ bool BackgroundFile::addTile(Tile &tile, uint colorOrIndex)
 	tile.tileID = tiles().size();
 	qDebug() << "addTile" << tile.layerID << tile.tileID << tile.textureID << tile.srcX << tile.srcY << tile.depth << tile.size << tile.dstX << tile.dstY << tile.ID << tile.IDBig << tile.blending << tile.typeTrans;
 	_tiles.insert(tile);
+	invalidateTileStore();
 	setModified(field()->isPC());
 
 	return true;
@@ -320,6 +532,7 @@ void BackgroundFile::createTiles(const QRect &rect, const Tile &model, uint colo
 bool BackgroundFile::setTile(Tile &tile)
 {
 	if (_tiles.replace(tile)) {
+		invalidateTileStore();
 		setModified(field()->isPC());
 		return true;
 	}
@@ -330,6 +543,7 @@ bool BackgroundFile::setTile(Tile &tile)
 bool BackgroundFile::removeTile(const Tile &tile)
 {
 	if (_tiles.remove(tile)) {
+		invalidateTileStore();
 		setModified(field()->isPC());
 		return true;
 	}
@@ -22,10 +22,12 @@
 #include "FieldPart.h"
 #include "Palette.h"
 #include "BackgroundTiles.h"
+#include "BackgroundTileStore.h"
 #include "BackgroundTextures.h"
 
 class BackgroundFile : public FieldPart
 {
+	friend class BackgroundCompositor;
 public:
 	explicit BackgroundFile(Field *field);
 	BackgroundFile(const BackgroundFile &other);
@@ -36,23 +38,30 @@ public:
 	using FieldPart::save;
 	virtual inline bool canSave() const override { return false; }
 	void clear() override;
-	QImage openBackground(bool transparent = false, bool *warning = nullptr);
-	QImage openBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent = false, bool *warning = nullptr);
+	// jobs: number of threads, 0 = one per core
+	QImage openBackground(bool transparent = false, bool *warning = nullptr, int jobs = 0);
+	QImage openBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent = false, bool *warning = nullptr, int jobs = 0);
 	QImage openBackground(const QHash<quint8, quint8> *paramActifs, const qint16 z[2],
 	                      const bool *layers = nullptr, const QSet<quint16> *IDs = nullptr,
-	                      bool onlyParams = false, bool transparent = false, bool *warning = nullptr);
+	                      bool onlyParams = false, bool transparent = false, bool *warning = nullptr,
+	                      int jobs = 0);
 	bool usedParams(QMap<LayerParam, quint8> &usedParams, bool *layerExists, QSet<quint16> *usedIDs, QList< QList<quint16> > *effectLayers = nullptr);
 	bool layerExists(int num);
 
 	bool exportTiles(const QString &fileName, const BackgroundTiles &tiles) const;
-	bool exportLayers(const QString &dirPath, const QString &extension) const;
+	bool exportLayers(const QString &dirPath, const QString &extension, int jobs = 0) const;
+	// Images saved by exportLayers(), with their file names, the palettes are resolved once
+	QList<std::pair<QString, QImage>> layerImages(const QString &extension, int jobs = 0) const;
 
 	inline const BackgroundTiles &tiles() const {
 		return _tiles;
 	}
 	inline void setTiles(const BackgroundTiles &tiles) {
 		_tiles = tiles;
+		invalidateTileStore();
 	}
+	// Indexed copy of tiles(), built on demand
+	const BackgroundTileStore &tileStore() const;
 
 	inline const Palettes &palettes() const {
 		return _palettes;
@@ -83,13 +92,26 @@ public:
 	virtual bool setTile(Tile &tile);
 	virtual bool removeTile(const Tile &tile);
 
-protected:
-	QImage drawBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent = false, bool *warning = nullptr) const;
 	static QRgb blendColor(quint8 type, QRgb color0, QRgb color1);
+protected:
+	QImage drawBackground(const BackgroundTiles &tiles, const QRect &area, bool transparent = false, bool *warning = nullptr, int jobs = 0) const;
+	QImage drawBackground(const BackgroundTiles &tiles, const QRect &area,
+	                      const std::vector<QRgb> &colors, const std::vector<quint32> &masks,
+	                      bool transparent = false, bool *warning = nullptr, int jobs = 0) const;
+	// Colors and transparency masks of the 256 entries of every palette
+	void paletteTables(std::vector<QRgb> &colors, std::vector<quint32> &masks) const;
+	// Draws the part of the tile inside clip, area is the background rect of the image
+	void drawTile(const Tile &tile, QRgb *pixels, const QRect &area, const QRect &clip,
+	              const QRgb *colors, const quint32 *masks, bool &warned) const;
+	// Same as drawTile() for every tile in this order, the clip is split
+	// into horizontal bands drawn on jobs threads
+	void drawTiles(const QList<const Tile *> &tiles, QRgb *pixels, const QRect &area, const QRect &clip,
+	               const QRgb *colors, const quint32 *masks, int jobs, bool &warned) const;
 	inline BackgroundTiles &tilesRef() {
+		invalidateTileStore();
 		return _tiles;
 	}
-	bool open(const QByteArray &data) override {
+	bool open(QByteArrayView data) override {
 		Q_UNUSED(data)
 		return false;
 	}
@@ -97,6 +119,9 @@ protected:
 	Palettes _palettes;
 
 private:
+	void invalidateTileStore();
+
 	BackgroundTiles _tiles;
+	mutable BackgroundTileStore *_tileStore;
 	BackgroundTextures *_textures;
 };
@@ -86,16 +86,18 @@ bool BackgroundFilePC::open()
 		return true;
 	}
 
-	return open(field()->sectionData(Field::Background),
-	            field()->sectionData(Field::PalettePC));
+	QByteArray buffer, palBuffer;
+
+	return open(field()->sectionView(Field::Background, buffer),
+	            field()->sectionView(Field::PalettePC, palBuffer));
 }
 
-bool BackgroundFilePC::open(const QByteArray &data, const QByteArray &palData)
+bool BackgroundFilePC::open(QByteArrayView data, QByteArrayView palData)
 {
 	QBuffer buff, palBuff;
 
-	buff.setData(data);
-	palBuff.setData(palData);
+	buff.setData(QByteArray::fromRawData(data.constData(), data.size()));
+	palBuff.setData(QByteArray::fromRawData(palData.constData(), palData.size()));
 
 	BackgroundIOPC io(&buff, &palBuff, nullptr);
 	if (!io.read(*this)) {
@@ -31,7 +31,7 @@ public:
 
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &data, const QByteArray &palData);
+	bool open(QByteArrayView data, QByteArrayView palData);
 	QByteArray save() const override;
 	QByteArray savePal() const;
 	virtual inline bool canSave() const override { return true; }
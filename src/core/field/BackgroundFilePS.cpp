@@ -53,16 +53,18 @@ bool BackgroundFilePS::open()
 		return true;
 	}
 
+	QByteArray buffer;
+
 	return open(static_cast<FieldPS *>(field())->io()->mimData(field()),
-	            field()->sectionData(Field::Background));
+	            field()->sectionView(Field::Background, buffer));
 }
 
-bool BackgroundFilePS::open(const QByteArray &mimData, const QByteArray &tilesData)
+bool BackgroundFilePS::open(QByteArrayView mimData, QByteArrayView tilesData)
 {
 	QBuffer mimBuff, tilesBuff;
 
-	mimBuff.setData(mimData);
-	tilesBuff.setData(tilesData);
+	mimBuff.setData(QByteArray::fromRawData(mimData.constData(), mimData.size()));
+	tilesBuff.setData(QByteArray::fromRawData(tilesData.constData(), tilesData.size()));
 
 	BackgroundIOPS io(&mimBuff, &tilesBuff);
 	if (!io.read(*this)) {
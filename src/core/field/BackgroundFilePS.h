@@ -32,7 +32,7 @@ public:
 
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &mimData, const QByteArray &tilesData);
+	bool open(QByteArrayView mimData, QByteArrayView tilesData);
 	QByteArray save() const override;
 	inline virtual BackgroundTexturesPS *textures() const override {
 		return static_cast<BackgroundTexturesPS *>(BackgroundFile::textures());
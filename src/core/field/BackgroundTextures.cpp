@@ -26,24 +26,35 @@ BackgroundTextures::~BackgroundTextures()
 {
 }
 
-QList<uint> BackgroundTextures::tile(const Tile &tile) const
+int BackgroundTextures::tileOrigin(const Tile &tile, int &textureWidth, int &lastByte) const
 {
-	QList<uint> indexOrRgbList;
-	quint8 depth = this->depth(tile), x = 0;
-	quint8 multiplicator = depth == 0 ? 1 : depth * 2;
-
 	int origin = originInData(tile);
 
 	if (origin == -1) {
-		return indexOrRgbList;
+		return -1;
 	}
 
-	int texWidth = textureWidth(tile);
+	textureWidth = this->textureWidth(tile);
 	int maxByte = data().size();
-	if (depth == 2) {
+	if (depth(tile) == 2) {
 		--maxByte;
 	}
-	int lastByte = qMin(origin + tile.size * texWidth, maxByte);
+	lastByte = qMin(origin + tile.size * textureWidth, maxByte);
+
+	return origin;
+}
+
+QList<uint> BackgroundTextures::tile(const Tile &tile) const
+{
+	QList<uint> indexOrRgbList;
+	quint8 depth = this->depth(tile), x = 0;
+	quint8 multiplicator = depth == 0 ? 1 : depth * 2;
+	int texWidth, lastByte;
+	int origin = tileOrigin(tile, texWidth, lastByte);
+
+	if (origin == -1) {
+		return indexOrRgbList;
+	}
 
 	for (int i = origin; i < lastByte; ++i) {
 		if (depth == 0) {
@@ -303,7 +314,54 @@ int BackgroundTexturesPC::originInData(const Tile &tile) const
 	return -1;
 }
 
+// Colors of the 15 significant bits of the PC format (bit 5 is unused)
+static const std::array<QRgb, 32768> &pcColorTable()
+{
+	static const std::array<QRgb, 32768> table = [] {
+		std::array<QRgb, 32768> colors;
+		for (quint32 i = 0; i < 32768; ++i) {
+			quint8 b = i & 31,
+			       g = (i >> 5) & 31,
+			       r = i >> 10;
+
+			// special PC RGB16 color
+			colors[i] = qRgb((r << 3) + (r >> 2), (g << 3) + (g >> 2), (b << 3) + (b >> 2));
+		}
+		return colors;
+	}();
+
+	return table;
+}
+
+// Every PS color, the conversion depends on the STP bit
+static const std::array<QRgb, 65536> &psColorTable()
+{
+	static const std::array<QRgb, 65536> table = [] {
+		std::array<QRgb, 65536> colors;
+		for (quint32 i = 0; i < 65536; ++i) {
+			colors[i] = PsColor::fromPsColor(quint16(i), true);
+		}
+		return colors;
+	}();
+
+	return table;
+}
+
 QRgb BackgroundTexturesPC::directColor(quint16 color) const
+{
+	return toQRgb(color);
+}
+
+void BackgroundTexturesPC::directColors(const uchar *src, int from, int to, QRgb *colors) const
+{
+	for (int x = from; x < to; ++x) {
+		quint16 color;
+		memcpy(&color, src + x * 2, 2);
+		colors[x] = toQRgb(color);
+	}
+}
+
+QRgb BackgroundTexturesPC::toQRgb(quint16 color)
 {
 	/* if (color == 0x821) {
 		return qRgb(8, 0, 16);
@@ -326,12 +384,7 @@ QRgb BackgroundTexturesPC::directColor(quint16 color) const
 		return qRgb(0, 0, 0);
 	}
 
-	quint8 b = color & 31,
-	       g = (color >> 6) & 31,
-	       r = color >> 11;
-
-	// special PC RGB16 color
-	return qRgb((r << 3) + (r >> 2), (g << 3) + (g >> 2), (b << 3) + (b >> 2));
+	return pcColorTable()[(color & 0x1F) | ((color >> 1) & 0x7FE0)];
 }
 
 quint16 BackgroundTexturesPC::fromQRgb(QRgb color) const
@@ -501,7 +554,7 @@ QImage BackgroundTexturesPC::toImage(quint8 texID, const BackgroundTiles &tiles,
 //					bits[pos + y * 256 + x] = qRgb(0, 0, 255);
 //				}
 				if (palette != nullptr) {
-					bits[pos + y * 256 + x] = palette->color(indexOrRgb);
+					bits[pos + y * 256 + x] = palette->colorTable()[quint8(indexOrRgb)];
 				} else {
 					bits[pos + y * 256 + x] = qRgb(indexOrRgb, indexOrRgb, indexOrRgb);
 				}
@@ -664,7 +717,18 @@ int BackgroundTexturesPS::originInData(const Tile &tile) const
 
 QRgb BackgroundTexturesPS::directColor(quint16 color) const
 {
-	return PsColor::fromPsColor(color, true);
+	return psColorTable()[color];
+}
+
+void BackgroundTexturesPS::directColors(const uchar *src, int from, int to, QRgb *colors) const
+{
+	const std::array<QRgb, 65536> &table = psColorTable();
+
+	for (int x = from; x < to; ++x) {
+		quint16 color;
+		memcpy(&color, src + x * 2, 2);
+		colors[x] = table[color];
+	}
 }
 
 quint16 BackgroundTexturesPS::fromQRgb(QRgb color) const
@@ -62,6 +62,11 @@ public:
 		_data.clear();
 	}
 	QList<uint> tile(const Tile &tile) const;
+	// Position of the tile in data(), or -1, lastByte is excluded
+	int tileOrigin(const Tile &tile, int &textureWidth, int &lastByte) const;
+	QRgb pixel(quint32 pos) const;
+	// Converts the direct colors of src into colors, from and to are pixel indexes
+	virtual void directColors(const uchar *src, int from, int to, QRgb *colors) const=0;
 	bool setTile(const Tile &tile, const QList<uint> &indexOrColor);
 	virtual inline quint8 depth(const Tile &tile) const {
 		return tile.depth;
@@ -73,7 +78,6 @@ protected:
 	virtual int originInData(const Tile &tile) const=0;
 	virtual QRgb directColor(quint16 color) const=0;
 	virtual quint16 fromQRgb(QRgb color) const=0;
-	QRgb pixel(quint32 pos) const;
 	QByteArray &data() {
 		return _data;
 	}
@@ -132,12 +136,14 @@ public:
 	                          const PalettesPS &palettesPS) const;
 	static TextureGroups textureGroup(const Tile &tile);
 	quint8 depth(const Tile &tile) const override;
+	void directColors(const uchar *src, int from, int to, QRgb *colors) const override;
 protected:
 	quint16 textureWidth(const Tile &tile) const override;
 	int originInData(const Tile &tile) const override;
 	QRgb directColor(quint16 color) const override;
 	quint16 fromQRgb(QRgb color) const override;
 private:
+	static QRgb toQRgb(quint16 color);
 	QMap<quint8, BackgroundTexturesPCInfos> _texInfos;
 };
 
@@ -153,6 +159,7 @@ public:
 	BackgroundTexturesPC toPC(const BackgroundTiles &psTiles,
 	                          BackgroundTiles &pcTiles,
 	                          const PalettesPC &palettesPC) const;
+	void directColors(const uchar *src, int from, int to, QRgb *colors) const override;
 protected:
 	quint16 textureWidth(const Tile &tile) const override;
 	int originInData(const Tile &tile) const override;
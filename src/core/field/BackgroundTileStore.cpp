@@ -0,0 +1,98 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "BackgroundTileStore.h"
+
+BackgroundTileStore::BackgroundTileStore()
+{
+}
+
+BackgroundTileStore::BackgroundTileStore(const BackgroundTiles &tiles)
+{
+	const qsizetype count = tiles.size();
+	_tiles.reserve(count);
+	_dstX.reserve(count);
+	_dstY.reserve(count);
+	_ID.reserve(count);
+	_layerID.reserve(count);
+	_param.reserve(count);
+	_state.reserve(count);
+
+	quint32 position = 0;
+
+	for (const Tile &tile : tiles) {
+		_tiles.append(tile);
+		_dstX.append(tile.dstX);
+		_dstY.append(tile.dstY);
+		_ID.append(tile.ID);
+		_layerID.append(tile.layerID);
+		_param.append(tile.param);
+		_state.append(tile.state);
+
+		if (tile.layerID < 4) {
+			_byLayer[tile.layerID].append(position);
+		}
+		if (tile.param > 0) {
+			_byParamState[paramStateKey(tile.layerID, ParamState(tile.param, tile.state))].append(position);
+		}
+		_byLayerID[layerIDKey(tile.layerID, tile.ID)].append(position);
+		_byID[tile.ID].append(position);
+		_byCell[cellKey(tile.layerID, tile.dstX, tile.dstY)].append(position);
+
+		position += 1;
+	}
+}
+
+BackgroundTileStore::Span BackgroundTileStore::layer(quint8 layerID) const
+{
+	return layerID < 4 ? Span(_byLayer[layerID]) : Span();
+}
+
+BackgroundTileStore::Span BackgroundTileStore::layer(quint8 layerID, ParamState paramState) const
+{
+	if (layerID == 0 || !paramState.isValid()) {
+		return Span();
+	}
+
+	return span(_byParamState, paramStateKey(layerID, paramState));
+}
+
+BackgroundTileStore::Span BackgroundTileStore::layer(quint8 layerID, quint16 ID) const
+{
+	return layerID == 1 ? span(_byLayerID, layerIDKey(layerID, ID)) : layer(layerID);
+}
+
+BackgroundTileStore::Span BackgroundTileStore::byID(quint16 ID) const
+{
+	return span(_byID, ID);
+}
+
+BackgroundTileStore::Span BackgroundTileStore::cell(quint8 layerID, qint16 dstX, qint16 dstY) const
+{
+	return span(_byCell, cellKey(layerID, dstX, dstY));
+}
+
+BackgroundTiles BackgroundTileStore::tiles(Span span) const
+{
+	BackgroundTiles ret;
+
+	for (quint32 position : span) {
+		ret.insert(_tiles.at(position));
+	}
+
+	return ret;
+}
@@ -0,0 +1,122 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include "BackgroundTiles.h"
+
+/*
+ * Flat copy of a BackgroundTiles, one column per queried attribute,
+ * with indices by layer, by (layer, param, state), by ID and by
+ * destination cell.
+ * Queries return spans of positions in the store, in the iteration
+ * order of the source BackgroundTiles, so no map is built.
+ * Spans are invalidated when the store is destroyed.
+ */
+class BackgroundTileStore
+{
+public:
+	class Span
+	{
+	public:
+		Span() : _begin(nullptr), _end(nullptr) {}
+		explicit Span(const QList<quint32> &positions) :
+		    _begin(positions.constData()), _end(positions.constData() + positions.size()) {}
+		inline const quint32 *begin() const {
+			return _begin;
+		}
+		inline const quint32 *end() const {
+			return _end;
+		}
+		inline qsizetype size() const {
+			return _end - _begin;
+		}
+		inline bool isEmpty() const {
+			return _begin == _end;
+		}
+	private:
+		const quint32 *_begin, *_end;
+	};
+
+	BackgroundTileStore();
+	explicit BackgroundTileStore(const BackgroundTiles &tiles);
+
+	inline qsizetype size() const {
+		return _tiles.size();
+	}
+	inline bool isEmpty() const {
+		return _tiles.isEmpty();
+	}
+	inline const Tile &tile(quint32 position) const {
+		return _tiles.at(position);
+	}
+	inline qint16 dstX(quint32 position) const {
+		return _dstX.at(position);
+	}
+	inline qint16 dstY(quint32 position) const {
+		return _dstY.at(position);
+	}
+	inline quint16 ID(quint32 position) const {
+		return _ID.at(position);
+	}
+	inline quint8 layerID(quint32 position) const {
+		return _layerID.at(position);
+	}
+	inline quint8 param(quint32 position) const {
+		return _param.at(position);
+	}
+	inline quint8 state(quint32 position) const {
+		return _state.at(position);
+	}
+
+	Span layer(quint8 layerID) const;
+	// Like BackgroundTiles::tiles(layerID, ParamState)
+	Span layer(quint8 layerID, ParamState paramState) const;
+	// Like BackgroundTiles::tiles(layerID, ID): the ID only filters layer 1
+	Span layer(quint8 layerID, quint16 ID) const;
+	Span byID(quint16 ID) const;
+	Span cell(quint8 layerID, qint16 dstX, qint16 dstY) const;
+
+	// Compatibility with the BackgroundTiles API
+	BackgroundTiles tiles(Span span) const;
+private:
+	inline static quint32 paramStateKey(quint8 layerID, ParamState paramState) {
+		return (quint32(layerID) << 16) | (quint32(paramState.param) << 8) | paramState.state;
+	}
+	inline static quint32 layerIDKey(quint8 layerID, quint16 ID) {
+		return (quint32(layerID) << 16) | ID;
+	}
+	inline static quint64 cellKey(quint8 layerID, qint16 dstX, qint16 dstY) {
+		return (quint64(layerID) << 32) | (quint64(quint16(dstX)) << 16) | quint16(dstY);
+	}
+	template<typename Key>
+	static Span span(const QHash<Key, QList<quint32>> &index, Key key) {
+		auto it = index.constFind(key);
+		return it == index.constEnd() ? Span() : Span(*it);
+	}
+
+	QList<Tile> _tiles;
+	QList<qint16> _dstX, _dstY;
+	QList<quint16> _ID;
+	QList<quint8> _layerID, _param, _state;
+
+	QList<quint32> _byLayer[4];
+	QHash<quint32, QList<quint32>> _byParamState, _byLayerID;
+	QHash<quint16, QList<quint32>> _byID;
+	QHash<quint64, QList<quint32>> _byCell;
+};
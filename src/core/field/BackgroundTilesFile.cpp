@@ -30,13 +30,15 @@ BackgroundTilesFile::~BackgroundTilesFile()
 
 bool BackgroundTilesFile::open()
 {
-	return open(field()->sectionData(Field::Tiles));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::Tiles, buffer));
 }
 
-bool BackgroundTilesFile::open(const QByteArray &data)
+bool BackgroundTilesFile::open(QByteArrayView data)
 {
 	QBuffer buffer;
-	buffer.setData(data);
+	buffer.setData(QByteArray::fromRawData(data.constData(), data.size()));
 
 	if (BackgroundTilesIOPS(&buffer).read(_tiles)) {
 		setOpen(true);
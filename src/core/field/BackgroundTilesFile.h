@@ -29,7 +29,7 @@ public:
 	virtual ~BackgroundTilesFile() override;
 
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	void clear() override;
 
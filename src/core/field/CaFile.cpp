@@ -45,10 +45,12 @@ void CaFile::initEmpty()
 
 bool CaFile::open()
 {
-	return open(field()->sectionData(Field::Camera));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::Camera, buffer));
 }
 
-bool CaFile::open(const QByteArray &data)
+bool CaFile::open(QByteArrayView data)
 {
 	const char *constData = data.constData();
 	qsizetype caSize = data.size();
@@ -31,10 +31,12 @@ void EncounterFile::initEmpty()
 
 bool EncounterFile::open()
 {
-	return open(field()->sectionData(Field::Encounter));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::Encounter, buffer));
 }
 
-bool EncounterFile::open(const QByteArray &data)
+bool EncounterFile::open(QByteArrayView data)
 {
 	if (sizeof(EncounterTable) != 24) {
 		qWarning() << "Encounter invalid struct size" << sizeof(EncounterTable);
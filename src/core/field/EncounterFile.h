@@ -41,7 +41,7 @@ public:
 	explicit EncounterFile(Field *field);
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	void clear() override;
 	const EncounterTable &encounterTable(Table tableID) const;
@@ -22,6 +22,7 @@
 #include "FieldPS.h"
 #include "BackgroundFilePC.h"
 #include "BackgroundFilePS.h"
+#include "core/LzsEncoder.h"
 
 Field::Field(const QString &name, FieldArchiveIO *io) :
     _io(io), _name(name.toLower()),
@@ -37,6 +38,7 @@ Field::Field(const QString &name) :
 
 Field::~Field()
 {
+	FieldArchiveIO::dataCache().remove(this);
 	for (FieldPart *part : qAsConst(_parts)) {
 		if (part) {
 			delete part;
@@ -61,7 +63,8 @@ void Field::setModified(bool modified)
 
 bool Field::open(bool dontOptimize)
 {
-	QByteArray fileData;
+	QByteArray buffer;
+	QByteArrayView fileData;
 
 	if (_io == nullptr) {
 		return false;
@@ -69,22 +72,11 @@ bool Field::open(bool dontOptimize)
 
 	if (headerSize() > 0) {
 		QString fileType = sectionFile(Scripts);
-		if (!dontOptimize && !_io->fieldDataIsCached(this, fileType)) {
-			QByteArray lzsData = _io->fieldData(this, fileType, false);
-
-			if (lzsData.size() < 4)	return false;
-
-			const char *lzsDataConst = lzsData.constData();
-			quint32 lzsSize;
-			memcpy(&lzsSize, lzsDataConst, 4);
-
-			if (quint32(lzsData.size()) != lzsSize + 4 && lzsSize == 0x90000) { // Maybe it is not compressed
-				fileData = lzsData;
-			} else {
-				fileData = LZS::decompress(lzsDataConst + 4, int(qMin(qsizetype(lzsSize), lzsData.size() - 4)), headerSize());//partial decompression
-			}
+		if (!dontOptimize) {
+			fileData = _io->fieldDataPart(this, fileType, 0, headerSize(), buffer);//partial decompression
 		} else {
-			fileData = _io->fieldData(this, fileType);
+			buffer = _io->fieldData(this, fileType);
+			fileData = buffer;
 		}
 
 		if (fileData.size() < headerSize())	return false;
@@ -125,52 +117,48 @@ int Field::sectionSize(FieldSection part) const
 }
 
 QByteArray Field::sectionData(FieldSection part, bool dontOptimize)
+{
+	QByteArray buffer;
+
+	return sectionView(part, buffer, dontOptimize).toByteArray();
+}
+
+QByteArrayView Field::sectionView(FieldSection part, QByteArray &buffer, bool dontOptimize)
 {
 	if (!_isOpen) {
 		open();
 	}
 
 	if (!_isOpen || _io == nullptr) {
-		return QByteArray();
+		return QByteArrayView();
 	}
 
 	int idPart = sectionId(part),
 			position = sectionPosition(idPart),
 			size = sectionSize(part);
 	QString fileType = sectionFile(part);
-
-	if (size < 0) {
-		dontOptimize = true;
-	}
-
-	QByteArray data;
-	if (dontOptimize || _io->fieldDataIsCached(this, fileType)) {
-		data = _io->fieldData(this, fileType);
-	} else {
-		QByteArray lzsData = _io->fieldData(this, fileType, false);
-
-		if (lzsData.size() < 4) {
-			return QByteArray();
-		}
-
-		const char *lzsDataConst = lzsData.constData();
-		quint32 lzsSize;
-		memcpy(&lzsSize, lzsDataConst, 4);
-
-		if (quint32(lzsData.size()) != lzsSize + 4 && lzsSize == 0x90000) { // Maybe it is not compressed
-			data = lzsData;
-		} else {
-			data = LZS::decompress(lzsDataConst + 4, qMin(lzsSize, quint32(lzsData.size() - 4)), sectionPosition(idPart+1));
+	QByteArrayView data;
+
+	if (dontOptimize) {
+		buffer = _io->fieldData(this, fileType);
+		if (position < buffer.size()) {
+			data = QByteArrayView(buffer).sliced(position);
+			if (size >= 0 && size < data.size()) {
+				data.truncate(size);
+			}
 		}
+	} else {
+		// fieldDataPart() resumes the decompression of the previous section
+		data = _io->fieldDataPart(this, fileType, position, size, buffer);
 	}
 
 	if (size < 0) {
 		QByteArray footer = saveFooter();
 		if (!footer.isEmpty() && data.endsWith(footer)) {
-			return data.mid(position, data.size() - position - footer.size());
+			data.chop(footer.size());
 		}
 	}
-	return data.mid(position, size);
+	return data;
 }
 
 FieldPart *Field::createPart(FieldSection section)
@@ -323,18 +311,20 @@ bool Field::save(QByteArray &newData, bool compress)
 
 	qDebug() << "save" << _name;
 
-	QByteArray toc;
+	QList<Field::FieldSection> fieldSections = orderOfSections();
 
-	// Header
-	toc.append(saveHeader());
+	// Header, section positions are filled in the loop
+	newData.append(saveHeader());
+	const qsizetype tocPos = newData.size();
+	newData.append(QByteArray(fieldSections.size() * 4, '\0'));
+	const qsizetype dataPos = newData.size();
 
 	// Sections
 	int id=0;
-	QList<Field::FieldSection> fieldSections = orderOfSections();
 	for (const FieldSection &fieldSection : qAsConst(fieldSections)) {
 		// Section position
-		quint32 pos = headerSize() + newData.size() + diffSectionPos();
-		toc.append((char *)&pos, 4);
+		quint32 pos = headerSize() + (newData.size() - dataPos) + diffSectionPos();
+		memcpy(newData.data() + tocPos + id * 4, &pos, 4);
 
 		QByteArray section;
 
@@ -353,8 +343,8 @@ bool Field::save(QByteArray &newData, bool compress)
 		newData.append(section);
 
 		// Alignment padding
-		if (alignment() > 0 && newData.size() % alignment() != 0) {
-			newData.append(QByteArray(alignment() - newData.size() % alignment(), '\0'));
+		if (alignment() > 0 && (newData.size() - dataPos) % alignment() != 0) {
+			newData.append(QByteArray(alignment() - (newData.size() - dataPos) % alignment(), '\0'));
 		}
 
 		++id;
@@ -363,13 +353,8 @@ bool Field::save(QByteArray &newData, bool compress)
 	// Footer
 	newData.append(saveFooter());
 
-	// Header prepended to the section data
-	newData.prepend(toc);
-
 	if (compress) {
-		const QByteArray &compresse = LZS::compress(newData);
-		quint32 lzsSize = quint32(compresse.size());
-		newData = QByteArray((char *)&lzsSize, 4).append(compresse);
+		newData = LzsEncoder::compressWithHeader(newData);
 	}
 
 	return true;
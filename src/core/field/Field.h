@@ -107,6 +107,9 @@ public:
 	}
 	int sectionSize(FieldSection part) const;
 	QByteArray sectionData(FieldSection part, bool dontOptimize=false);
+	// Section without copy, buffer keeps the decompressed data alive
+	// and is shared with the other sections of the same file
+	QByteArrayView sectionView(FieldSection part, QByteArray &buffer, bool dontOptimize=false);
 
 	inline void setRemoveUnusedSection(bool remove) { // FIXME: only in PC version, ugly hack detected!
 		_removeUnusedSection = remove;
@@ -116,7 +119,7 @@ public:
 	}
 protected:
 	virtual int headerSize() const=0;
-	virtual void openHeader(const QByteArray &fileData)=0;
+	virtual void openHeader(QByteArrayView fileData)=0;
 	virtual QByteArray saveHeader() const=0;
 	virtual QByteArray saveFooter() const=0;
 	virtual FieldPart *createPart(FieldSection part);
@@ -17,7 +17,10 @@
  ****************************************************************************/
 #include "FieldArchive.h"
 #include "Data.h"
+#include "core/LzsEncoder.h"
+#include "core/Parallel.h"
 #include <PsfFile.h>
+#include <LZS>
 
 SearchIn::~SearchIn()
 {
@@ -98,12 +101,12 @@ Field *FieldArchiveIterator::openField(Field *field, bool open, bool dontOptimiz
 }
 
 FieldArchive::FieldArchive() :
-	_io(nullptr), _observer(nullptr)
+	_io(nullptr), _observer(nullptr), _jobCount(0), _exportedImageCount(0)
 {
 }
 
 FieldArchive::FieldArchive(FieldArchiveIO *io) :
-	_io(io), _observer(nullptr)
+	_io(io), _observer(nullptr), _jobCount(0), _exportedImageCount(0)
 {
 	//	fileWatcher.addPath(path);
 	//	connect(&fileWatcher, &QFileSystemWatcher::fileChanged, this, &FieldArchive::fileChanged);
@@ -112,13 +115,16 @@ FieldArchive::FieldArchive(FieldArchiveIO *io) :
 
 FieldArchive::~FieldArchive()
 {
+	if (_io && _scriptIndex.isModified()) {
+		_scriptIndex.save(_io->path());
+	}
 	qDeleteAll(fileList);
 	if (_io) {
 		delete _io;
 	}
 }
 
-FieldArchiveIO::ErrorCode FieldArchive::open()
+FieldArchiveIO::ErrorCode FieldArchive::open(OpenMode mode)
 {
 	if (!_io)	return FieldArchiveIO::Invalid;
 
@@ -141,17 +147,64 @@ FieldArchiveIO::ErrorCode FieldArchive::open()
 		++fieldID;
 	}
 
+	_scriptIndex.load(_io->path());
+
+	if (mode == OpenAllFields) {
+		return openAllFields();
+	}
+
 	return FieldArchiveIO::Ok;
 }
 
+FieldArchiveIO::ErrorCode FieldArchive::openAllFields()
+{
+	QList<Field *> fields;
+
+	for (Field *f : qAsConst(fileList)) {
+		if (f != nullptr && !f->isOpen() && f->io() != nullptr) {
+			fields.append(f);
+		}
+	}
+
+	if (_observer) {
+		_observer->setObserverMaximum(uint(fields.size()));
+	}
+
+	// Reading is serialized by the IO, headers are decoded on the workers
+	bool ok = Parallel::orderedFor(fields.size(), _jobCount, [&](qsizetype i) {
+		fields.at(i)->open();
+	}, [&](qsizetype i) {
+		if (_observer) {
+			if (_observer->observerWasCanceled()) {
+				return false;
+			}
+			_observer->setObserverValue(int(i));
+		}
+		return true;
+	});
+
+	return ok ? FieldArchiveIO::Ok : FieldArchiveIO::Aborted;
+}
+
 FieldArchiveIO::ErrorCode FieldArchive::save(const QString &path)
 {
 	if (!_io)	return FieldArchiveIO::Invalid;
 
+	updateScriptIndex();
+
 	FieldArchiveIO::ErrorCode error = _io->save(path, observer());
 	if (error == FieldArchiveIO::Ok) {
 		// Clear "isModified" state
 		setSaved();
+		_scriptIndex.setSaved();
+		if (path.isEmpty() || QDir::cleanPath(path) == QDir::cleanPath(_io->path())) {
+			_scriptIndex.save(_io->path());
+		} else {
+			// Saved as another archive: the index describes the
+			// destination now, the source one is kept on disk
+			_scriptIndex.save(path);
+			_scriptIndex.clear();
+		}
 	}
 	return error;
 }
@@ -167,6 +220,7 @@ void FieldArchive::clear()
 	fileList.clear();
 	fieldsSortByName.clear();
 	_mapList.clear();
+	_scriptIndex.clear();
 }
 
 FieldArchiveIO *FieldArchive::io() const
@@ -179,6 +233,48 @@ void FieldArchive::setIO(FieldArchiveIO *io)
 	_io = io;
 }
 
+bool FieldArchive::scriptsMayContain(Field *field, int mapID, quint32 indexKey)
+{
+	if (indexKey == ScriptIndex::NoKey) {
+		return true;
+	}
+
+	Section1File *scripts = field->isOpen() ? field->scriptsAndTexts(false) : nullptr;
+	if (scripts != nullptr && scripts->isOpen() && scripts->isModified()) {
+		_scriptIndex.addField(mapID, scripts, false);
+	} else if (!_scriptIndex.contains(mapID)) {
+		return true;
+	}
+
+	return _scriptIndex.fieldContains(mapID, indexKey);
+}
+
+void FieldArchive::indexScripts(Field *field, int mapID)
+{
+	if (!field->isOpen() || _scriptIndex.contains(mapID)) {
+		return;
+	}
+
+	Section1File *scripts = field->scriptsAndTexts(false);
+	if (scripts != nullptr && scripts->isOpen()) {
+		_scriptIndex.addField(mapID, scripts, !scripts->isModified());
+	}
+}
+
+void FieldArchive::updateScriptIndex()
+{
+	for (auto it = fileList.constBegin(); it != fileList.constEnd(); ++it) {
+		Field *f = it.value();
+		if (f == nullptr || !f->isOpen()) {
+			continue;
+		}
+		Section1File *scripts = f->scriptsAndTexts(false);
+		if (scripts != nullptr && scripts->isOpen() && scripts->isModified()) {
+			_scriptIndex.addField(it.key(), scripts, false);
+		}
+	}
+}
+
 bool FieldArchive::openField(Field *field, bool dontOptimize)
 {
 	if (!field->isOpen()) {
@@ -254,6 +350,7 @@ void FieldArchive::delField(int mapId)
 	_mapList.softDeleteMap(field->name());
 
 	fileList.insert(mapId, nullptr);
+	_scriptIndex.removeField(mapId);
 	delete field;
 }
 
@@ -269,6 +366,7 @@ int FieldArchive::appendField(Field *field)
 		}
 	}
 	fileList.insert(int(mapId), field);
+	_scriptIndex.removeField(int(mapId));
 	return int(mapId);
 }
 
@@ -294,29 +392,50 @@ bool FieldArchive::isModified() const
 	return false;
 }
 
-QList<FF7Var> FieldArchive::searchAllVars(QMap<FF7Var, QSet<QString> > &fieldNames)
+bool FieldArchive::searchAllVars(VarUsage &usage)
 {
-	QList<FF7Var> vars;
-	FieldArchiveIterator it(*this);
+	const QList<int> mapIDs = fileList.keys();
+	// A partial usage per chunk of fields, merged in order on the calling thread
+	const qsizetype chunkSize = 16,
+	        chunkCount = (mapIDs.size() + chunkSize - 1) / chunkSize;
+	std::vector<std::unique_ptr<VarUsage>> chunks(size_t(chunkCount));
 
-	while (it.hasNext()) {
-		Field *field = it.next();
+	usage.clear();
 
-		if (field != nullptr) {
-			QList<FF7Var> fieldVars;
-			field->scriptsAndTexts()->searchAllVars(fieldVars);
+	if (_observer) {
+		_observer->setObserverMaximum(uint(chunkCount));
+	}
+
+	return Parallel::orderedFor(chunkCount, _jobCount, [&](qsizetype chunk) {
+		std::unique_ptr<VarUsage> chunkUsage = std::make_unique<VarUsage>();
+		const qsizetype end = qMin((chunk + 1) * chunkSize, mapIDs.size());
+		QList<FF7Var> vars;
+
+		for (qsizetype i = chunk * chunkSize; i < end; ++i) {
+			const int mapID = mapIDs.at(i);
+			Field *f = fileList.value(mapID);
 
-			for (const FF7Var &fieldVar : qAsConst(fieldVars)) {
-				QSet<QString> names = fieldNames.value(fieldVar);
-				names.insert(field->scriptsAndTexts()->author());
-				fieldNames.insert(fieldVar, names);
+			if (f != nullptr && openField(f)) {
+				vars.clear();
+				f->scriptsAndTexts()->searchAllVars(vars);
+				chunkUsage->addField(mapID, vars);
 			}
+		}
+
+		chunks[size_t(chunk)] = std::move(chunkUsage);
+	}, [&](qsizetype chunk) {
+		usage.merge(*chunks[size_t(chunk)]);
+		chunks[size_t(chunk)].reset();
 
-			vars.append(fieldVars);
+		if (_observer) {
+			if (_observer->observerWasCanceled()) {
+				return false;
+			}
+			_observer->setObserverValue(int(chunk));
 		}
-	}
 
-	return vars;
+		return true;
+	});
 }
 
 #ifdef DEBUG_FUNCTIONS
@@ -1111,6 +1230,429 @@ void FieldArchive::printBackgroundZ()
 	deb2.close();
 }
 
+// Previous implementation of BackgroundFile::drawBackground, for comparison
+static QImage drawBackgroundReference(const BackgroundFile *bg, const BackgroundTiles &tiles, const QRect &area)
+{
+	QImage image(area.size(), QImage::Format_ARGB32);
+	image.fill(0xFF000000);
+	QRgb *pixels = reinterpret_cast<QRgb *>(image.bits());
+
+	for (const Tile &tile : tiles) {
+		QList<uint> indexOrColorList = bg->textures()->tile(tile);
+		quint8 depth = bg->textures()->depth(tile);
+		Palette *palette = nullptr;
+
+		if (indexOrColorList.isEmpty() || depth > 2
+		        || (depth <= 1 && tile.paletteID >= bg->palettes().size())) {
+			continue;
+		}
+		if (depth <= 1) {
+			palette = bg->palettes().at(tile.paletteID);
+		}
+
+		quint8 right = 0;
+		qint32 top = (area.y() + tile.dstY) * area.width();
+		qint32 baseX = area.x() + tile.dstX;
+
+		for (uint indexOrColor : qAsConst(indexOrColorList)) {
+			QRgb &pixel = pixels[baseX + right + top];
+			if (palette == nullptr) {
+				if (indexOrColor != 0) {
+					pixel = qRgb(qRed(indexOrColor), qGreen(indexOrColor), qBlue(indexOrColor));
+				}
+			} else if (palette->notZero(quint8(indexOrColor))) {
+				pixel = tile.blending
+				        ? BackgroundFile::blendColor(tile.typeTrans, pixel, palette->color(quint8(indexOrColor)))
+				        : palette->color(quint8(indexOrColor));
+			}
+
+			if (++right == tile.size) {
+				right = 0;
+				top += area.width();
+			}
+		}
+	}
+
+	return image;
+}
+
+void FieldArchive::benchmarkBackgrounds()
+{
+	QElapsedTimer t;
+	qint64 referenceTime = 0, currentTime = 0;
+	int count = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (field && field->isOpen()) {
+			BackgroundFile *bg = field->background();
+
+			if (!bg->isOpen() || bg->tiles().isEmpty()) {
+				continue;
+			}
+
+			const BackgroundTiles &tiles = bg->tiles();
+			const QRect area = tiles.rect();
+
+			t.start();
+			QImage reference = drawBackgroundReference(bg, tiles, area);
+			referenceTime += t.nsecsElapsed();
+
+			t.start();
+			QImage current = bg->openBackground(tiles, area);
+			currentTime += t.nsecsElapsed();
+
+			if (reference != current) {
+				qWarning() << "FieldArchive::benchmarkBackgrounds different image" << field->name();
+			}
+			++count;
+		}
+	}
+
+	qDebug() << "FieldArchive::benchmarkBackgrounds" << count << "backgrounds"
+	         << "reference" << referenceTime / 1000000 << "ms"
+	         << "current" << currentTime / 1000000 << "ms";
+}
+
+// The background drawn in bands on several threads must be identical to the serial one
+void FieldArchive::checkParallelBackgrounds()
+{
+	QElapsedTimer t;
+	qint64 serialTime = 0, parallelTime = 0;
+	int count = 0, errorCount = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (field && field->isOpen()) {
+			BackgroundFile *bg = field->background();
+
+			if (!bg->isOpen() || bg->tiles().isEmpty()) {
+				continue;
+			}
+
+			const BackgroundTiles &tiles = bg->tiles();
+			const QRect area = tiles.rect();
+
+			for (bool transparent : {false, true}) {
+				t.start();
+				QImage serial = bg->openBackground(tiles, area, transparent, nullptr, 1);
+				serialTime += t.nsecsElapsed();
+
+				t.start();
+				QImage parallel = bg->openBackground(tiles, area, transparent, nullptr, _jobCount);
+				parallelTime += t.nsecsElapsed();
+
+				if (serial != parallel) {
+					qWarning() << "FieldArchive::checkParallelBackgrounds different image" << field->name() << transparent;
+					++errorCount;
+				}
+			}
+			++count;
+		}
+	}
+
+	qDebug() << "FieldArchive::checkParallelBackgrounds" << count << "backgrounds"
+	         << errorCount << "errors"
+	         << "serial" << serialTime / 1000000 << "ms"
+	         << "parallel" << parallelTime / 1000000 << "ms";
+}
+
+// Previous implementation of BackgroundTexturesPC::directColor, for comparison
+static QRgb directColorPCReference(quint16 color)
+{
+	if (color == 0x0) {
+		return qRgba(0, 0, 0, 0);
+	}
+
+	if (color == 0x821) {
+		return qRgb(0, 0, 0);
+	}
+
+	quint8 b = color & 31,
+	       g = (color >> 6) & 31,
+	       r = color >> 11;
+
+	return qRgb((r << 3) + (r >> 2), (g << 3) + (g >> 2), (b << 3) + (b >> 2));
+}
+
+void FieldArchive::benchmarkPalettes()
+{
+	const int passes = 256;
+	QElapsedTimer t;
+	qint64 referenceTime = 0, currentTime = 0;
+	quint64 referenceSum = 0, currentSum = 0;
+	int count = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (field && field->isOpen()) {
+			BackgroundFile *bg = field->background();
+
+			if (!bg->isOpen()) {
+				continue;
+			}
+
+			for (const Palette *palette : bg->palettes()) {
+				const QRgb *colors = palette->colorTable();
+				const quint32 *masks = palette->maskTable();
+
+				t.start();
+				for (int pass = 0; pass < passes; ++pass) {
+					for (int i = 0; i < palette->size(); ++i) {
+						if (palette->notZero(quint8(i))) {
+							referenceSum += palette->color(i);
+						}
+					}
+				}
+				referenceTime += t.nsecsElapsed();
+
+				t.start();
+				for (int pass = 0; pass < passes; ++pass) {
+					for (int i = 0; i < 256; ++i) {
+						currentSum += colors[i] & masks[i];
+					}
+				}
+				currentTime += t.nsecsElapsed();
+
+				for (int i = 0; i < palette->size(); ++i) {
+					if (colors[i] != palette->color(i)
+					        || (masks[i] != 0) != palette->notZero(quint8(i))) {
+						qWarning() << "FieldArchive::benchmarkPalettes different color" << field->name() << i;
+						break;
+					}
+				}
+				++count;
+			}
+		}
+	}
+
+	qDebug() << "FieldArchive::benchmarkPalettes" << count << "palettes"
+	         << "reference" << referenceTime / 1000000 << "ms"
+	         << "current" << currentTime / 1000000 << "ms"
+	         << (referenceSum == currentSum ? "same sum" : "different sum");
+
+	// Every 16-bit value of the direct color textures
+	QByteArray data(65536 * 2, Qt::Uninitialized);
+	for (int i = 0; i < 65536; ++i) {
+		quint16 color = quint16(i);
+		memcpy(data.data() + i * 2, &color, 2);
+	}
+	const uchar *src = reinterpret_cast<const uchar *>(data.constData());
+	QList<QRgb> reference(65536), current(65536);
+
+	t.start();
+	for (int pass = 0; pass < passes; ++pass) {
+		for (int i = 0; i < 65536; ++i) {
+			reference[i] = isPC() ? directColorPCReference(quint16(i)) : PsColor::fromPsColor(quint16(i), true);
+		}
+	}
+	referenceTime = t.nsecsElapsed();
+
+	BackgroundTexturesPC texturesPC;
+	BackgroundTexturesPS texturesPS;
+	const BackgroundTextures *textures = isPC() ? static_cast<BackgroundTextures *>(&texturesPC) : &texturesPS;
+
+	t.start();
+	for (int pass = 0; pass < passes; ++pass) {
+		textures->directColors(src, 0, 65536, current.data());
+	}
+	currentTime = t.nsecsElapsed();
+
+	qDebug() << "FieldArchive::benchmarkPalettes direct colors"
+	         << "reference" << referenceTime / 1000000 << "ms"
+	         << "current" << currentTime / 1000000 << "ms"
+	         << (reference == current ? "same colors" : "different colors");
+}
+
+void FieldArchive::benchmarkLzsEncoder()
+{
+	const LzsEncoder::Level levels[] = {
+		LzsEncoder::Fast, LzsEncoder::Default, LzsEncoder::MaxRatio
+	};
+	QElapsedTimer t;
+	qint64 times[3] = {0, 0, 0}, sizes[3] = {0, 0, 0}, referenceTime = 0, referenceSize = 0,
+	        totalSize = 0;
+	int count = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (!field || !field->isOpen() || !field->io()) {
+			continue;
+		}
+
+		const QByteArray data = field->io()->fieldData(field, field->isPC() ? QString() : "DAT");
+		if (data.isEmpty()) {
+			continue;
+		}
+
+		for (int level = 0; level < 3; ++level) {
+			t.start();
+			const QByteArray compressed = LzsEncoder::compress(data, levels[level]);
+			times[level] += t.nsecsElapsed();
+			sizes[level] += compressed.size();
+
+			// Round trip with the ff7tk decompressor
+			if (LZS::decompressAll(compressed) != data) {
+				qWarning() << "FieldArchive::benchmarkLzsEncoder round trip error" << field->name() << level;
+			}
+		}
+
+		t.start();
+		referenceSize += LZS::compress(data).size();
+		referenceTime += t.nsecsElapsed();
+
+		totalSize += data.size();
+		++count;
+	}
+
+	if (totalSize == 0) {
+		return;
+	}
+
+	auto report = [totalSize](const char *name, qint64 time, qint64 size) {
+		qDebug() << "FieldArchive::benchmarkLzsEncoder" << name
+		         << (time > 0 ? totalSize * 1000.0 / time : 0.0) << "MB/s"
+		         << "ratio" << double(size) / totalSize;
+	};
+
+	qDebug() << "FieldArchive::benchmarkLzsEncoder" << count << "fields" << totalSize << "bytes";
+	report("fast", times[0], sizes[0]);
+	report("default", times[1], sizes[1]);
+	report("max ratio", times[2], sizes[2]);
+	report("ff7tk", referenceTime, referenceSize);
+}
+
+void FieldArchive::benchmarkScriptMemory()
+{
+	qint64 opcodeCount = 0, packedSize = 0, unpackedSize = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (!field || !field->isOpen()) {
+			continue;
+		}
+
+		Section1File *scripts = field->scriptsAndTexts();
+		if (!scripts->isOpen()) {
+			continue;
+		}
+
+		for (const GrpScript &grpScript : scripts->grpScripts()) {
+			for (const Script &script : grpScript.scripts()) {
+				Script copy = script;
+				copy.pack();
+				const QByteArray packedData = copy.toByteArray();
+				packedSize += copy.memoryUsage();
+				opcodeCount += copy.size();
+
+				copy.opcodes(); // Unpack
+				unpackedSize += copy.memoryUsage();
+
+				if (copy.toByteArray() != packedData) {
+					qWarning() << "FieldArchive::benchmarkScriptMemory round trip error" << field->name() << grpScript.name();
+				}
+			}
+		}
+	}
+
+	if (opcodeCount == 0) {
+		return;
+	}
+
+	qDebug() << "FieldArchive::benchmarkScriptMemory" << opcodeCount << "opcodes"
+	         << "unpacked" << unpackedSize << "bytes" << double(unpackedSize) / opcodeCount << "bytes/opcode"
+	         << "packed" << packedSize << "bytes" << double(packedSize) / opcodeCount << "bytes/opcode";
+}
+
+void FieldArchive::benchmarkScriptParsing()
+{
+	QList<QByteArray> scriptsData;
+	qint64 totalSize = 0, opcodeCount = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (!field || !field->isOpen()) {
+			continue;
+		}
+
+		Section1File *scripts = field->scriptsAndTexts();
+		if (!scripts->isOpen()) {
+			continue;
+		}
+
+		for (const GrpScript &grpScript : scripts->grpScripts()) {
+			for (const Script &script : grpScript.scripts()) {
+				if (!script.isEmpty()) {
+					scriptsData.append(script.toByteArray());
+					totalSize += scriptsData.last().size();
+				}
+			}
+		}
+	}
+
+	if (totalSize == 0) {
+		return;
+	}
+
+	QElapsedTimer t;
+	t.start();
+
+	for (const QByteArray &data : qAsConst(scriptsData)) {
+		Script script(data.constData(), data.size());
+		opcodeCount += script.size();
+	}
+
+	qint64 time = qMax(t.nsecsElapsed(), qint64(1));
+
+	qDebug() << "FieldArchive::benchmarkScriptParsing" << scriptsData.size() << "scripts"
+	         << opcodeCount << "opcodes" << totalSize << "bytes"
+	         << scriptsData.size() * 1000000000.0 / time << "scripts/s"
+	         << totalSize * 1000.0 / time << "MB/s";
+}
+
+// Sections already opened are not read again: to run on a fresh archive
+void FieldArchive::benchmarkFieldDataCache()
+{
+	FieldDataCache &cache = FieldArchiveIO::dataCache();
+	cache.clear();
+	cache.resetStats();
+
+	QElapsedTimer t;
+	t.start();
+	int count = 0;
+	FieldArchiveIterator it(*this);
+
+	while (it.hasNext()) {
+		Field *field = it.next();
+
+		if (field && field->isOpen()) {
+			field->scriptsAndTexts();
+			field->background();
+			++count;
+		}
+	}
+
+	const FieldDataCache::Stats stats = cache.stats();
+
+	qDebug() << "FieldArchive::benchmarkFieldDataCache" << count << "fields"
+	         << t.elapsed() << "ms"
+	         << "hits" << stats.hits << "misses" << stats.misses
+	         << "evictions" << stats.evictions
+	         << stats.count << "entries" << stats.cost / 1024 << "KiB";
+}
+
 void FieldArchive::searchAll()
 {
 	QTime t;t.start();
@@ -1454,7 +1996,7 @@ void FieldArchive::searchAll()
 
 bool FieldArchive::find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 						SearchQuery *toSearch, int &mapID, SearchIn *searchIn,
-						Sorting sorting, SearchScope scope)
+						Sorting sorting, SearchScope scope, quint32 indexKey)
 {
 	Q_UNUSED(sorting)
 	FieldArchiveIterator it(*this);
@@ -1463,10 +2005,17 @@ bool FieldArchive::find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 	}
 
 	while (it.hasNext()) {
-		Field *f = it.next();
+		Field *f = it.next(false);
 		mapID = it.mapId();
-		if (f != nullptr && (*predicate)(f, toSearch, searchIn)) {
-			return true;
+		if (f != nullptr && scriptsMayContain(f, mapID, indexKey)) {
+			openField(f);
+			bool found = (*predicate)(f, toSearch, searchIn);
+			if (indexKey != ScriptIndex::NoKey) {
+				indexScripts(f, mapID);
+			}
+			if (found) {
+				return true;
+			}
 		}
 		searchIn->reset();
 		if (scope >= FieldScope) {
@@ -1478,7 +2027,7 @@ bool FieldArchive::find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 
 bool FieldArchive::findLast(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 						SearchQuery *toSearch, int &mapID, SearchIn *searchIn,
-						Sorting sorting, SearchScope scope)
+						Sorting sorting, SearchScope scope, quint32 indexKey)
 {
 	Q_UNUSED(sorting)
 	FieldArchiveIterator it(*this);
@@ -1487,10 +2036,17 @@ bool FieldArchive::findLast(bool (*predicate)(Field *, SearchQuery *, SearchIn *
 	}
 
 	while (it.hasPrevious()) {
-		Field *f = it.previous();
+		Field *f = it.previous(false);
 		mapID = it.key();
-		if (f != nullptr && (*predicate)(f, toSearch, searchIn)) {
-			return true;
+		if (f != nullptr && scriptsMayContain(f, mapID, indexKey)) {
+			openField(f);
+			bool found = (*predicate)(f, toSearch, searchIn);
+			if (indexKey != ScriptIndex::NoKey) {
+				indexScripts(f, mapID);
+			}
+			if (found) {
+				return true;
+			}
 		}
 		searchIn->toEnd();
 		if (scope >= FieldScope) {
@@ -1510,7 +2066,8 @@ bool FieldArchive::searchOpcode(int opcode, int &mapID, int &groupID, int &scrip
 		SearchOpcodeQuery *query = static_cast<SearchOpcodeQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchOpcode(query->opcode, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::opcodeKey(opcode));
 }
 
 bool FieldArchive::searchVar(quint8 bank, quint16 address, Opcode::Operation op, int value, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1522,7 +2079,8 @@ bool FieldArchive::searchVar(quint8 bank, quint16 address, Opcode::Operation op,
 		SearchVarQuery *query = static_cast<SearchVarQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchVar(query->bank, query->address, query->op, query->value, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::varKey(bank, address));
 }
 
 bool FieldArchive::searchExec(quint8 group, quint8 script, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1534,7 +2092,8 @@ bool FieldArchive::searchExec(quint8 group, quint8 script, int &mapID, int &grou
 		SearchExecQuery *query = static_cast<SearchExecQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchExec(query->group, query->script, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::execKey(group, script));
 }
 
 bool FieldArchive::searchMapJump(int map, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1546,7 +2105,8 @@ bool FieldArchive::searchMapJump(int map, int &mapID, int &groupID, int &scriptI
 		SearchFieldQuery *query = static_cast<SearchFieldQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchMapJump(quint16(query->mapID), searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::mapJumpKey(quint16(map)));
 }
 
 bool FieldArchive::searchTextInScripts(const QRegularExpression &text, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1583,7 +2143,8 @@ bool FieldArchive::searchOpcodeP(int opcode, int &mapID, int &groupID, int &scri
 		SearchOpcodeQuery *query = static_cast<SearchOpcodeQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchOpcodeP(query->opcode, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::opcodeKey(opcode));
 }
 
 bool FieldArchive::searchVarP(quint8 bank, quint16 address, Opcode::Operation op, int value, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1595,7 +2156,8 @@ bool FieldArchive::searchVarP(quint8 bank, quint16 address, Opcode::Operation op
 		SearchVarQuery *query = static_cast<SearchVarQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchVarP(query->bank, query->address, query->op, query->value, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::varKey(bank, address));
 }
 
 bool FieldArchive::searchExecP(quint8 group, quint8 script, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1607,7 +2169,8 @@ bool FieldArchive::searchExecP(quint8 group, quint8 script, int &mapID, int &gro
 		SearchExecQuery *query = static_cast<SearchExecQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchExecP(query->group, query->script, searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::execKey(group, script));
 }
 
 bool FieldArchive::searchMapJumpP(int map, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1619,7 +2182,8 @@ bool FieldArchive::searchMapJumpP(int map, int &mapID, int &groupID, int &script
 		SearchFieldQuery *query = static_cast<SearchFieldQuery *>(_query);
 		SearchInScript *searchIn = static_cast<SearchInScript *>(_searchIn);
 		return f->scriptsAndTexts()->searchMapJumpP(quint16(query->mapID), searchIn->groupID, searchIn->scriptID, searchIn->opcodeID);
-	}, &query, mapID, &searchIn, sorting, scope);
+	}, &query, mapID, &searchIn, sorting, scope,
+	ScriptIndex::mapJumpKey(quint16(map)));
 }
 
 bool FieldArchive::searchTextInScriptsP(const QRegularExpression &text, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope)
@@ -1769,127 +2333,231 @@ void FieldArchive::autosizeTextWindows()
 	}
 }
 
+bool FieldArchive::patchFields(const QList<int> &selectedFields, const std::function<bool (Field *)> &patch)
+{
+	QList<Field *> fields;
+	for (const int &mapID : selectedFields) {
+		fields.append(field(mapID, false));
+	}
+
+	if (observer()) {
+		observer()->setObserverMaximum(uint(fields.size()));
+	}
+
+	// Each field is only touched by one worker,
+	// the archive state is updated from the calling thread
+	std::vector<quint8> modified(size_t(fields.size()), false);
+
+	return Parallel::orderedFor(fields.size(), _jobCount, [&](qsizetype i) {
+		Field *f = fields.at(i);
+		if (f != nullptr && (f->isOpen() || f->open())) {
+			modified[size_t(i)] = patch(f);
+		}
+	}, [&](qsizetype i) {
+		if (modified[size_t(i)] && !fields.at(i)->isModified()) {
+			fields.at(i)->setModified(true);
+		}
+
+		if (observer()) {
+			if (observer()->observerWasCanceled()) {
+				return false;
+			}
+			observer()->setObserverValue(int(i));
+		}
+
+		return true;
+	});
+}
+
 bool FieldArchive::exportation(const QList<int> &selectedFields, const QString &directory,
 							   bool overwrite, const QMap<ExportType, QString> &toExport,
                                PsfTags *tags)
 {
+	_exportedImageCount = 0;
+
 	if (selectedFields.isEmpty() || toExport.isEmpty()) {
 		return true;
 	}
 
-	QString path, extension;
-	int currentField = 0;
+	if (toExport.contains(Texts) && toExport.value(Texts) != "txt"
+	        && toExport.value(Texts) != "xml") {
+		return false;
+	}
+
+	QList<Field *> fields;
+	for (const int &mapID : selectedFields) {
+		fields.append(field(mapID, false));
+	}
+
 	if (observer()) {
 		observer()->setObserverMaximum(quint32(selectedFields.size() - 1));
 	}
 
-	for (const int &mapID : selectedFields) {
-		if (observer() && observer()->observerWasCanceled()) {
-			break;
+	// Fields are opened, drawn and encoded on the workers, files are written
+	// in order by the calling thread
+	std::vector<QList<ExportedFile> > files(size_t(fields.size()));
+	std::vector<quint8> exported(size_t(fields.size()), true),
+	        opened(size_t(fields.size()), true);
+	bool ok = true;
+
+	Parallel::orderedFor(fields.size(), _jobCount, [&](qsizetype i) {
+		Field *f = fields.at(i);
+		if (f != nullptr) {
+			if (!f->isOpen() && !f->open()) {
+				opened[size_t(i)] = false;
+				return;
+			}
+			exported[size_t(i)] = exportField(f, directory, overwrite, toExport, tags, files[size_t(i)]);
 		}
-		Field *f = field(mapID);
-		if (f) {
-			if (toExport.contains(Fields)) {
-				extension = toExport.value(Fields);
-				path = QDir::cleanPath(extension.isEmpty()
-									   ? QString("%1/%2")
-										 .arg(directory, f->name())
-									   : QString("%1/%2.%3")
-										 .arg(directory, f->name(), extension));
-				if (overwrite || !QFile::exists(path)) {
-					QByteArray fieldData = io()->fieldData(f, io()->isPC() ? QString() : "DAT", extension.compare("dec", Qt::CaseInsensitive) == 0);
-					if (!fieldData.isEmpty()) {
-						QFile fieldExport(path);
-						if (fieldExport.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-							fieldExport.write(fieldData);
-							fieldExport.close();
-						}
-					}
+	}, [&](qsizetype i) {
+		if (!opened[size_t(i)]) {
+			qWarning() << "FieldArchive::exportation: cannot open field" << selectedFields.at(i);
+		}
+
+		QList<ExportedFile> fieldFiles = std::move(files[size_t(i)]);
+
+		for (const ExportedFile &file : qAsConst(fieldFiles)) {
+			QFile fileExport(file.path);
+			if (fileExport.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+				fileExport.write(file.data);
+				fileExport.close();
+				if (file.isImage) {
+					++_exportedImageCount;
 				}
 			}
-			if (toExport.contains(Backgrounds)) {
-				extension = toExport.value(Backgrounds);
-				bool exportLayers = extension.endsWith('_');
-				path = QDir::cleanPath(QString("%1/%2").arg(directory, f->name()));
-				if (exportLayers) {
-					extension.truncate(extension.size() - 1);
-				} else {
-					path.append(QString(".%3").arg(extension));
-				}
+		}
 
-				if (overwrite || !QFile::exists(path)) {
-					BackgroundFile *bg = f->background();
-					if (bg->isOpen()) {
-						if (exportLayers) {
-							bg->exportLayers(path, extension);
-						} else {
-							QImage background = bg->openBackground();
-							if (!background.isNull()) {
-								background.save(path);
-							}
-						}
-					}
-				}
+		if (!exported[size_t(i)]) {
+			ok = false;
+			return false;
+		}
+
+		if (observer()) {
+			if (observer()->observerWasCanceled()) {
+				return false;
 			}
-			if (toExport.contains(Akaos)) {
-				TutFileStandard *akaoList = f->tutosAndSounds();
-				if (akaoList->isOpen()) {
-					int akaoCount = int(akaoList->size());
-					for (int i=0; i<akaoCount; ++i) {
-						if (!akaoList->isTut(i)) {
-							extension = toExport.value(Akaos);
-							path = QDir::cleanPath(QString("%1/%2.%3").arg(directory, Data::music_names.value(akaoList->akaoID(i), f->name()), extension));
-							if (overwrite || !QFile::exists(path)) {
-								QFile tutExport(path);
-								if (tutExport.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-									if (extension == "minipsf" || extension == "psf") {
-										tags->setTitle(Data::music_desc.value(akaoList->akaoID(i), f->name()));
-										tutExport.write(PsfFile::fromAkao(akaoList->data(i), *tags).save());
-									} else {
-										tutExport.write(akaoList->data(i));
-									}
-									tutExport.close();
-								}
-							}
+			observer()->setObserverValue(int(i));
+		}
+
+		return true;
+	});
+
+	return ok;
+}
+
+static bool encodeImage(const QImage &image, const QString &format, QByteArray &data)
+{
+	if (image.isNull()) {
+		return false;
+	}
+
+	QBuffer buffer(&data);
+	buffer.open(QIODevice::WriteOnly);
+
+	return image.save(&buffer, qPrintable(format));
+}
+
+bool FieldArchive::exportField(Field *f, const QString &directory, bool overwrite,
+                               const QMap<ExportType, QString> &toExport,
+                               const PsfTags *tags, QList<ExportedFile> &files) const
+{
+	QString path, extension;
+
+	if (toExport.contains(Fields)) {
+		extension = toExport.value(Fields);
+		path = QDir::cleanPath(extension.isEmpty()
+							   ? QString("%1/%2")
+								 .arg(directory, f->name())
+							   : QString("%1/%2.%3")
+								 .arg(directory, f->name(), extension));
+		if (overwrite || !QFile::exists(path)) {
+			QByteArray fieldData = io()->fieldData(f, io()->isPC() ? QString() : "DAT", extension.compare("dec", Qt::CaseInsensitive) == 0);
+			if (!fieldData.isEmpty()) {
+				files.append(ExportedFile(path, fieldData));
+			}
+		}
+	}
+	if (toExport.contains(Backgrounds)) {
+		extension = toExport.value(Backgrounds);
+		bool exportLayers = extension.endsWith('_');
+		path = QDir::cleanPath(QString("%1/%2").arg(directory, f->name()));
+		if (exportLayers) {
+			extension.truncate(extension.size() - 1);
+		} else {
+			path.append(QString(".%3").arg(extension));
+		}
+
+		if (overwrite || !QFile::exists(path)) {
+			BackgroundFile *bg = f->background();
+			if (bg->isOpen()) {
+				// Already on a worker: the images are drawn on this thread
+				if (exportLayers) {
+					QDir dir(path);
+					if (!dir.exists()) {
+						dir.mkpath("./");
+					}
+					const QList<std::pair<QString, QImage>> images = bg->layerImages(extension, 1);
+					for (const std::pair<QString, QImage> &image : images) {
+						QByteArray data;
+						if (encodeImage(image.second, extension, data)) {
+							files.append(ExportedFile(dir.filePath(image.first), data, true));
 						}
 					}
+				} else {
+					QByteArray data;
+					if (encodeImage(bg->openBackground(false, nullptr, 1), QFileInfo(path).suffix(), data)) {
+						files.append(ExportedFile(path, data, true));
+					}
 				}
 			}
-			if (toExport.contains(Texts)) {
-				Section1File *section1 = f->scriptsAndTexts();
-				if (section1->isOpen()) {
-					extension = toExport.value(Texts);
-					path = QDir::cleanPath(QString("%1/%2.%3").arg(directory, f->name(), extension));
+		}
+	}
+	if (toExport.contains(Akaos)) {
+		TutFileStandard *akaoList = f->tutosAndSounds();
+		if (akaoList->isOpen()) {
+			int akaoCount = int(akaoList->size());
+			for (int i=0; i<akaoCount; ++i) {
+				if (!akaoList->isTut(i)) {
+					extension = toExport.value(Akaos);
+					path = QDir::cleanPath(QString("%1/%2.%3").arg(directory, Data::music_names.value(akaoList->akaoID(i), f->name()), extension));
 					if (overwrite || !QFile::exists(path)) {
-						QFile textExport(path);
-						Section1File::ExportFormat format;
-						if (extension == "txt") {
-							format = Section1File::TXTText;
-						} else if (extension == "xml") {
-							format = Section1File::XMLText;
+						if (extension == "minipsf" || extension == "psf") {
+							PsfTags akaoTags = *tags;
+							akaoTags.setTitle(Data::music_desc.value(akaoList->akaoID(i), f->name()));
+							files.append(ExportedFile(path, PsfFile::fromAkao(akaoList->data(i), akaoTags).save()));
 						} else {
-							return false;
-						}
-
-						if (!section1->exporter(&textExport, format)) {
-							return false;
+							files.append(ExportedFile(path, akaoList->data(i)));
 						}
 					}
 				}
 			}
-			if (toExport.contains(Chunks)) {
-				path = QDir::cleanPath(QString("%1/%2").arg(directory, f->name()));
-				QDir dir(path);
-				if (!dir.exists()) {
-					dir.mkpath("./");
-				}
-				if (!f->exportToChunks(dir)) {
+		}
+	}
+	if (toExport.contains(Texts)) {
+		Section1File *section1 = f->scriptsAndTexts();
+		if (section1->isOpen()) {
+			extension = toExport.value(Texts);
+			path = QDir::cleanPath(QString("%1/%2.%3").arg(directory, f->name(), extension));
+			if (overwrite || !QFile::exists(path)) {
+				QByteArray data;
+				QBuffer textExport(&data);
+				if (!section1->exporter(&textExport, extension == "txt"
+				                                     ? Section1File::TXTText
+				                                     : Section1File::XMLText)) {
 					return false;
 				}
+				files.append(ExportedFile(path, data));
 			}
 		}
-		if (observer()) {
-			observer()->setObserverValue(currentField++);
+	}
+	if (toExport.contains(Chunks)) {
+		path = QDir::cleanPath(QString("%1/%2").arg(directory, f->name()));
+		QDir dir(path);
+		if (!dir.exists()) {
+			dir.mkpath("./");
+		}
+		if (!f->exportToChunks(dir)) {
+			return false;
 		}
 	}
 
@@ -23,6 +23,8 @@
 #include "FieldArchiveIO.h"
 #include "Field.h"
 #include "MapList.h"
+#include "ScriptIndex.h"
+#include "VarUsage.h"
 #include <PsfFile>
 
 struct SearchQuery
@@ -136,13 +138,18 @@ public:
 	};
 	Q_DECLARE_FLAGS(ExportTypes, ExportType)
 
+	enum OpenMode {
+		OpenLazily, OpenAllFields
+	};
+
 	FieldArchive();
 	explicit FieldArchive(FieldArchiveIO *io);
 	virtual ~FieldArchive();
 	virtual bool isPC() const=0;
 	inline bool isPS() const { return !isPC(); }
 
-	FieldArchiveIO::ErrorCode open();
+	FieldArchiveIO::ErrorCode open(OpenMode mode = OpenLazily);
+	FieldArchiveIO::ErrorCode openAllFields();
 	FieldArchiveIO::ErrorCode save(const QString &path=QString());
 	void close();
 
@@ -159,7 +166,8 @@ public:
 
 	bool isAllOpened() const;
 	bool isModified() const;
-	QList<FF7Var> searchAllVars(QMap<FF7Var, QSet<QString> > &fieldNames);
+	// Scans the fields on jobCount() threads, returns false if canceled
+	bool searchAllVars(VarUsage &usage);
 #ifdef DEBUG_FUNCTIONS
 	void validateAsk();
 	void validateOneLineSize();
@@ -173,14 +181,27 @@ public:
 	void diffScripts();
 	bool printBackgroundTiles(bool uniformize = false, bool fromUnusedPCSection = false);
 	void printBackgroundZ();
+	void benchmarkBackgrounds();
+	void benchmarkPalettes();
+	void checkParallelBackgrounds();
+	void benchmarkLzsEncoder();
+	void benchmarkScriptMemory();
+	void benchmarkScriptParsing();
+	void benchmarkFieldDataCache();
 	void searchAll();// research & debug function
 #endif
 	bool find(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 			  SearchQuery *toSearch, int &mapID, SearchIn *searchIn,
-			  Sorting sorting, SearchScope scope);
+			  Sorting sorting, SearchScope scope, quint32 indexKey = ScriptIndex::NoKey);
 	bool findLast(bool (*predicate)(Field *, SearchQuery *, SearchIn *),
 				  SearchQuery *toSearch, int &mapID, SearchIn *searchIn,
-				  Sorting sorting, SearchScope scope);
+				  Sorting sorting, SearchScope scope, quint32 indexKey = ScriptIndex::NoKey);
+	// false only if the script index tells that indexKey is not in this field
+	bool scriptsMayContain(Field *field, int mapID, quint32 indexKey);
+	void indexScripts(Field *field, int mapID);
+	inline const ScriptIndex &scriptIndex() const {
+		return _scriptIndex;
+	}
 	bool searchOpcode(int opcode, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope);
 	bool searchVar(quint8 bank, quint16 address, Opcode::Operation op, int value, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope);
 	bool searchExec(quint8 group, quint8 script, int &mapID, int &groupID, int &scriptID, int &opcodeID, Sorting sorting, SearchScope scope);
@@ -196,6 +217,8 @@ public:
 	bool replaceText(const QRegularExpression &search, const QString &after, int mapID, int textID, int from);
 
 	bool compileScripts(int &mapID, int &groupID, int &scriptID, int &opcodeID, QString &errorStr);
+	// Runs patch on jobCount() threads, fields are marked as modified when it returns true
+	bool patchFields(const QList<int> &selectedFields, const std::function<bool (Field *)> &patch);
 	void removeBattles();
 	void removeTexts();
 	void cleanTexts();
@@ -204,6 +227,10 @@ public:
 	bool exportation(const QList<int> &selectedFields, const QString &directory,
 	                 bool overwrite, const QMap<ExportType, QString> &toExport,
 	                 PsfTags *tags = nullptr);
+	// Number of background images written by the last exportation()
+	inline qsizetype exportedImageCount() const {
+		return _exportedImageCount;
+	}
 	bool importation(const QList<int> &selectedFields, const QString &directory,
 	                 const QMap<Field::FieldSection, QString> &toImport);
 
@@ -211,6 +238,13 @@ public:
 	inline void setObserver(ArchiveObserver *observer) {
 		_observer = observer;
 	}
+	// Number of threads used by batch operations (0 = one per core)
+	inline int jobCount() const {
+		return _jobCount;
+	}
+	inline void setJobCount(int jobCount) {
+		_jobCount = jobCount;
+	}
 	inline const MapList &mapList() const {
 		return _mapList;
 	}
@@ -226,18 +260,33 @@ protected:
 		return _observer;
 	}
 private:
+	struct ExportedFile {
+		ExportedFile(const QString &path, const QByteArray &data, bool isImage = false) :
+		    path(path), data(data), isImage(isImage) {}
+		QString path;
+		QByteArray data;
+		bool isImage;
+	};
+
+	bool exportField(Field *f, const QString &directory, bool overwrite,
+	                 const QMap<ExportType, QString> &toExport,
+	                 const PsfTags *tags, QList<ExportedFile> &files) const;
 	const Field *field(const QString &name) const;
 	Field *field(const QString &name, bool open = true, bool dontOptimize = false);
 	int indexOfField(const QString &name) const;
 	void updateFieldLists(Field *field, int fieldID);
+	void updateScriptIndex();
 	static bool openField(Field *field, bool dontOptimize = false);
 
 	QMap<int, Field *> fileList;
 	QMap<QString, int> fieldsSortByName;
 	MapList _mapList;
+	ScriptIndex _scriptIndex;
 
 	FieldArchiveIO *_io;
 	ArchiveObserver *_observer;
+	int _jobCount;
+	qsizetype _exportedImageCount;
 	// QFileSystemWatcher fileWatcher;
 };
 
@@ -15,23 +15,23 @@
  ** You should have received a copy of the GNU General Public License
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
-#include <LZS>
 #include "FieldArchiveIO.h"
 #include "FieldArchive.h"
 #include "Field.h"
+#include "core/LzsDecoder.h"
+#include "core/Parallel.h"
 
-QByteArray FieldArchiveIO::fieldDataCache;
-Field *FieldArchiveIO::fieldCache = nullptr;
-QString FieldArchiveIO::fieldExtensionCache;
+FieldDataCache FieldArchiveIO::_dataCache;
 
 FieldArchiveIO::FieldArchiveIO(FieldArchive *fieldArchive) :
-	_fieldArchive(fieldArchive)
+	_fieldArchive(fieldArchive), _memoryMapped(false)
 {
 }
 
 FieldArchiveIO::~FieldArchiveIO()
 {
 	clearCachedData();
+	qDeleteAll(_mappedFiles);
 }
 
 FieldArchive *FieldArchiveIO::fieldArchive()
@@ -67,28 +67,79 @@ QString FieldArchiveIO::directory() const
 
 QByteArray FieldArchiveIO::fieldData(Field *field, const QString &extension, bool unlzs)
 {
+	QByteArray data;
+
 	// use data from the cache
-	if (unlzs && fieldDataIsCached(field, extension)) {
-//		qDebug() << "FieldArchive use field data from cache" << field->name();
-		return fieldDataCache;
-	} /*else {
-		qDebug() << "FieldArchive don't use field data from cache" << field->name() << unlzs;
-	}*/
+	if (unlzs && _dataCache.find(field, extension, data)) {
+		return data;
+	}
 
-	QByteArray data = fieldData2(field, extension, unlzs);
+	data = fieldData2(field, extension, unlzs);
 
 	// put decompressed data in the cache
 	if (unlzs && !data.isEmpty()) {
-		fieldCache = field;
-		fieldDataCache = data;
-		fieldExtensionCache = extension;
+		_dataCache.insert(field, extension, data);
 	}
 	return data;
 }
 
+QByteArrayView FieldArchiveIO::fieldDataPart(Field *field, const QString &extension,
+                                             qsizetype position, qsizetype size,
+                                             QByteArray &buffer)
+{
+	LzsDecoder decoder;
+	qsizetype available;
+	bool compressed = true;
+
+	if (_dataCache.find(field, extension, buffer)) {
+		compressed = false;
+	} else if (!_dataCache.takeDecoder(field, extension, decoder)) {
+		buffer = fieldData(field, extension, false);
+
+		if (buffer.size() < 4) {
+			return QByteArrayView();
+		}
+
+		quint32 lzsSize;
+		memcpy(&lzsSize, buffer.constData(), 4);
+
+		if (quint32(buffer.size()) != lzsSize + 4 && lzsSize == 0x90000) { // Maybe it is not compressed
+			compressed = false;
+		} else {
+			decoder = LzsDecoder(buffer, 4, qsizetype(lzsSize));
+		}
+	}
+
+	if (!compressed) {
+		available = buffer.size();
+	} else {
+		available = decoder.decompressTo(size < 0 ? -1 : position + size);
+
+		if (decoder.atEnd()) {
+			buffer = decoder.takeData();
+			_dataCache.insert(field, extension, buffer);
+		} else {
+			buffer = decoder.buffer();
+			_dataCache.putDecoder(field, extension, decoder);
+		}
+	}
+
+	if (position >= available) {
+		return QByteArrayView();
+	}
+
+	return QByteArrayView(buffer).sliced(position, size < 0 ? available - position : qMin(size, available - position));
+}
+
 QByteArray FieldArchiveIO::fileData(const QString &fileName, bool unlzs)
 {
-	QByteArray data = fileData2(fileName);
+	QByteArray data;
+
+	// Devices are not reentrant, but the decompression can run concurrently
+	{
+		QMutexLocker locker(&_ioMutex);
+		data = fileData2(fileName);
+	}
 
 	if (unlzs) {
 		if (data.size() < 4) {
@@ -104,7 +155,7 @@ QByteArray FieldArchiveIO::fileData(const QString &fileName, bool unlzs)
 		}
 
 		return unlzs
-			? LZS::decompressAll(lzsDataConst + 4, int(qMin(qsizetype(lzsSize), data.size() - 4)))
+			? LzsDecoder::decompressAll(lzsDataConst + 4, qMin(qsizetype(lzsSize), data.size() - 4))
 			: data;
 	}
 	return data;
@@ -130,19 +181,57 @@ int FieldArchiveIO::exportFieldData(Field *field, const QString &extension, cons
 
 bool FieldArchiveIO::fieldDataIsCached(Field *field, const QString &fileType)
 {
-	return fieldCache && fieldCache == field && fieldExtensionCache == fileType;
+	return _dataCache.contains(field, fileType);
+}
+
+FieldDataCache &FieldArchiveIO::dataCache()
+{
+	return _dataCache;
 }
 
 void FieldArchiveIO::clearCachedData()
 {
-//	qDebug() << "FieldArchive::clearCachedData()";
-	fieldCache = nullptr;
-	fieldDataCache.clear();
+	_dataCache.clear();
+}
+
+void FieldArchiveIO::setMemoryMapped(bool mapped)
+{
+	if (!mapped) {
+		unmapFiles();
+	}
+	_memoryMapped = mapped;
+}
+
+QByteArray FieldArchiveIO::mappedFileData(const QString &path, qint64 position, qint64 size)
+{
+	MappedFile *file = _mappedFiles.value(path);
+
+	if (file == nullptr) {
+		file = new MappedFile();
+		// Failures are kept too, to not try again
+		file->open(path);
+		_mappedFiles.insert(path, file);
+	}
+
+	return file->data(position, size);
+}
+
+void FieldArchiveIO::unmapFiles()
+{
+	if (_mappedFiles.isEmpty()) {
+		return;
+	}
+
+	// Cached data can point to the mappings
+	clearCachedData();
+	qDeleteAll(_mappedFiles);
+	_mappedFiles.clear();
 }
 
 void FieldArchiveIO::close()
 {
 	clearCachedData();
+	unmapFiles();
 }
 
 FieldArchiveIO::ErrorCode FieldArchiveIO::open(ArchiveObserver *observer)
@@ -154,13 +243,63 @@ FieldArchiveIO::ErrorCode FieldArchiveIO::open(ArchiveObserver *observer)
 
 FieldArchiveIO::ErrorCode FieldArchiveIO::save(const QString &path, ArchiveObserver *observer)
 {
+	// The archive will be rewritten, it must not be mapped
+	const bool memoryMapped = _memoryMapped;
+	setMemoryMapped(false);
+
 	ErrorCode error = save2(path, observer);
+	_memoryMapped = memoryMapped;
 	if (error == Ok) {
 		clearCachedData(); // Important: the file data will change
 	}
 	return error;
 }
 
+FieldArchiveIO::ErrorCode FieldArchiveIO::saveModifiedFields(const FieldSerializer &serialize,
+                                                             const FieldWriter &write,
+                                                             ArchiveObserver *observer)
+{
+	QList<Field *> fields;
+	FieldArchiveIterator it(*_fieldArchive);
+
+	while (it.hasNext()) {
+		Field *field = it.next(false);
+		if (field && field->isOpen() && field->isModified()) {
+			fields.append(field);
+		}
+	}
+
+	if (observer) {
+		observer->setObserverMaximum(uint(fields.size()));
+	}
+
+	std::vector<QList<QByteArray>> files(size_t(fields.size()));
+	std::vector<char> serialized(size_t(fields.size()), false);
+	ErrorCode error = Ok;
+
+	Parallel::orderedFor(fields.size(), _fieldArchive->jobCount(), [&](qsizetype i) {
+		serialized[size_t(i)] = serialize(fields.at(i), files[size_t(i)]);
+	}, [&](qsizetype i) {
+		if (observer) {
+			if (observer->observerWasCanceled()) {
+				error = Aborted;
+				return false;
+			}
+			observer->setObserverValue(int(i) + 1);
+		}
+		if (!serialized[size_t(i)]) {
+			qWarning() << "FieldArchiveIO::saveModifiedFields cannot save" << fields.at(i)->name();
+			error = Invalid;
+			return false;
+		}
+		error = write(fields.at(i), files[size_t(i)]);
+		files[size_t(i)] = QList<QByteArray>();
+		return error == Ok;
+	});
+
+	return error;
+}
+
 FieldArchiveIO::ErrorCode FieldArchiveIO::addField(const QString &fileName,
                                                    const QString &name)
 {
@@ -168,3 +307,36 @@ FieldArchiveIO::ErrorCode FieldArchiveIO::addField(const QString &fileName,
 	Q_UNUSED(name)
 	return NotImplemented;
 }
+
+ArchiveObserverRange::ArchiveObserverRange(ArchiveObserver *observer, int from, int to) :
+	_observer(observer), _from(from), _to(to), _last(from), _max(0)
+{
+}
+
+bool ArchiveObserverRange::observerWasCanceled() const
+{
+	return _observer && _observer->observerWasCanceled();
+}
+
+void ArchiveObserverRange::setObserverMaximum(unsigned int max)
+{
+	_max = max;
+}
+
+void ArchiveObserverRange::setObserverValue(int value)
+{
+	if (!_observer || _max == 0) {
+		return;
+	}
+
+	int scaled = _from + int(qint64(qBound(0, value, int(_max))) * (_to - _from) / _max);
+	if (scaled > _last) {
+		_last = scaled;
+		_observer->setObserverValue(scaled);
+	}
+}
+
+bool ArchiveObserverRange::observerRetry(const QString &message)
+{
+	return _observer && _observer->observerRetry(message);
+}
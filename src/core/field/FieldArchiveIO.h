@@ -19,6 +19,8 @@
 
 #include <QtCore>
 #include <Archive>
+#include "FieldDataCache.h"
+#include "core/MappedFile.h"
 
 class FieldArchive;
 class Field;
@@ -43,10 +45,24 @@ public:
 	inline bool isPC() const { return !isPS(); }
 
 	QByteArray fieldData(Field *field, const QString &extension, bool unlzs = true);
+	// Decompressed data from position, size < 0 means up to the end.
+	// The decompression is resumed from the previous call for this file.
+	// The view points to buffer, which shares the data with the cache
+	QByteArrayView fieldDataPart(Field *field, const QString &extension, qsizetype position,
+	                             qsizetype size, QByteArray &buffer);
 	QByteArray fileData(const QString &fileName, bool unlzs = true);
 	int exportFieldData(Field *field, const QString &extension, const QString &path, bool unlzs = true);
 
+	// For read-only batch jobs (export, search...): files are views on
+	// a memory mapping of the archive, without copy, when supported.
+	// The mappings are released on close() and before saving
+	void setMemoryMapped(bool mapped);
+	inline bool isMemoryMapped() const {
+		return _memoryMapped;
+	}
+
 	static bool fieldDataIsCached(Field *field, const QString &fileType);
+	static FieldDataCache &dataCache();
 	virtual void clearCachedData();
 
 	virtual void close();
@@ -63,6 +79,8 @@ public:
 	virtual Type type() const=0;
 
 	virtual Archive *device()=0;
+	// Peak memory used by the last save, 0 when unknown
+	virtual inline qint64 savePeakMemory() const { return 0; }
 	FieldArchive *fieldArchive();
 protected:
 	virtual QByteArray fieldData2(Field *field, const QString &extension, bool unlzs)=0;
@@ -70,9 +88,40 @@ protected:
 
 	virtual ErrorCode open2(ArchiveObserver *observer)=0;
 	virtual ErrorCode save2(const QString &path, ArchiveObserver *observer)=0;
+
+	typedef std::function<bool (Field *field, QList<QByteArray> &files)> FieldSerializer;
+	typedef std::function<ErrorCode (Field *field, const QList<QByteArray> &files)> FieldWriter;
+	// Serializes the modified fields on fieldArchive()->jobCount() threads,
+	// then calls write() on this thread in the field order
+	ErrorCode saveModifiedFields(const FieldSerializer &serialize, const FieldWriter &write,
+	                             ArchiveObserver *observer);
+	// View on the file mapping, null if the file cannot be mapped.
+	// Only called from fileData2()
+	QByteArray mappedFileData(const QString &path, qint64 position = 0, qint64 size = -1);
+	virtual void unmapFiles();
 private:
 	FieldArchive *_fieldArchive;
-	static QByteArray fieldDataCache, mimDataCache, modelDataCache;
-	static Field *fieldCache, *mimCache, *modelCache;
-	static QString fieldExtensionCache;
+	QMutex _ioMutex;
+	QHash<QString, MappedFile *> _mappedFiles;
+	bool _memoryMapped;
+	static FieldDataCache _dataCache;
+};
+
+/*
+ * Reports the progress of a step as the [from, to] part
+ * of the observer range, without going backwards.
+ */
+class ArchiveObserverRange : public ArchiveObserver
+{
+public:
+	ArchiveObserverRange(ArchiveObserver *observer, int from, int to);
+
+	bool observerWasCanceled() const override;
+	void setObserverMaximum(unsigned int max) override;
+	void setObserverValue(int value) override;
+	bool observerRetry(const QString &message) override;
+private:
+	ArchiveObserver *_observer;
+	int _from, _to, _last;
+	unsigned int _max;
 };
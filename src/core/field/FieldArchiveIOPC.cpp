@@ -18,9 +18,9 @@
 #include "FieldArchiveIOPC.h"
 #include "FieldPC.h"
 #include "FieldArchivePC.h"
-#include "FieldIO.h"
 #include "Data.h"
 #include "MapList.h"
+#include "core/Config.h"
 
 FieldArchiveIOPC::FieldArchiveIOPC(FieldArchivePC *fieldArchive) :
 	FieldArchiveIO(fieldArchive)
@@ -33,7 +33,8 @@ FieldArchivePC *FieldArchiveIOPC::fieldArchive()
 }
 
 FieldArchiveIOPCLgp::FieldArchiveIOPCLgp(const QString &path, FieldArchivePC *fieldArchive) :
-	FieldArchiveIOPC(fieldArchive), _lgp(path), observer(nullptr)
+	FieldArchiveIOPC(fieldArchive), _lgp(path), observer(nullptr),
+	_savePeakMemory(0), _filesAdded(false)
 {
 }
 
@@ -41,6 +42,7 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::addField(const QString &fileName,
                                                         const QString &name)
 {
 	if (_lgp.addFile(name, new QFile(fileName))) {
+		_filesAdded = true;
 		return FieldArchiveIO::Ok;
 	}
 	return FieldArchiveIO::FieldExists;
@@ -64,6 +66,13 @@ QByteArray FieldArchiveIOPCLgp::fieldData2(Field *field, const QString &extensio
 
 QByteArray FieldArchiveIOPCLgp::fileData2(const QString &fileName)
 {
+	if (isMemoryMapped()) {
+		QByteArray data = mappedLgpFileData(fileName);
+		if (!data.isNull()) {
+			return data;
+		}
+	}
+
 	if (!_lgp.isOpen() && !_lgp.open()) return QByteArray();
 	QByteArray data = _lgp.fileData(fileName);
 	if (data.isEmpty()) {
@@ -72,6 +81,52 @@ QByteArray FieldArchiveIOPCLgp::fileData2(const QString &fileName)
 	return data;
 }
 
+QByteArray FieldArchiveIOPCLgp::mappedLgpFileData(const QString &fileName)
+{
+	if (_mappedToc.isEmpty()) {
+		const QByteArray archive = mappedFileData(_lgp.fileName());
+		if (archive.size() < 16) {
+			return QByteArray();
+		}
+
+		// Header: 12 bytes company name, file count,
+		// then 27 bytes per file: 20 bytes name, data position, ...
+		const char *constData = archive.constData();
+		qint32 fileCount = qFromLittleEndian<qint32>(constData + 12);
+		if (fileCount <= 0 || 16 + qint64(fileCount) * 27 > archive.size()) {
+			return QByteArray();
+		}
+
+		for (qint32 i = 0; i < fileCount; ++i) {
+			const char *entry = constData + 16 + i * 27;
+			quint32 position = qFromLittleEndian<quint32>(entry + 20);
+			// Data: 20 bytes name, size, content
+			if (position + qint64(24) > archive.size()) {
+				continue;
+			}
+			quint32 size = qFromLittleEndian<quint32>(constData + position + 20);
+			if (position + qint64(24) + size > archive.size()) {
+				continue;
+			}
+			QString name = QString::fromLatin1(entry, int(qstrnlen(entry, 20))).toLower();
+			_mappedToc.insert(name, qMakePair(qint64(position) + 24, qint64(size)));
+		}
+	}
+
+	auto it = _mappedToc.constFind(fileName.toLower());
+	if (it == _mappedToc.constEnd()) {
+		return QByteArray();
+	}
+
+	return mappedFileData(_lgp.fileName(), it->first, it->second);
+}
+
+void FieldArchiveIOPCLgp::unmapFiles()
+{
+	_mappedToc.clear();
+	FieldArchiveIOPC::unmapFiles();
+}
+
 void FieldArchiveIOPCLgp::close()
 {
 	_lgp.close();
@@ -146,11 +201,138 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::open2(ArchiveObserver *observer)
 	return Ok;
 }
 
+bool FieldArchiveIOPCLgp::canStreamSave(const QString &path)
+{
+	if (_filesAdded || (!path.isEmpty() && QFileInfo(path) != QFileInfo(_lgp.fileName()))) {
+		return false;
+	}
+
+	FieldArchiveIterator it(*(fieldArchive()));
+
+	while (it.hasNext()) {
+		Field *field = it.next(false);
+		if (field && field->isOpen() && field->isModified()
+		        && (field->isRenamed() || !_lgp.fileExists(field->name()))) {
+			return false;
+		}
+	}
+
+	// Otherwise Lgp::pack() is used, for example when entries share their data
+	return LgpWriter(_lgp.fileName()).canWrite();
+}
+
+static bool serializeField(Field *field, QList<QByteArray> &files)
+{
+	QByteArray data;
+	if (!field->save(data, true)) {
+		return false;
+	}
+	files.append(data);
+	return true;
+}
+
+FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::streamSave(ArchiveObserver *observer)
+{
+	if (observer) {
+		observer->setObserverMaximum(100);
+	}
+	ArchiveObserverRange fieldsObserver(observer, 0, 50), writeObserver(observer, 50, 100);
+	LgpWriter writer(_lgp.fileName());
+	_savePeakMemory = 0;
+
+	ErrorCode error = saveModifiedFields(serializeField,
+	                                     [&writer](Field *field, const QList<QByteArray> &files) {
+		writer.setEntryData(field->name(), files.first());
+		return Ok;
+	}, &fieldsObserver);
+
+	if (error != Ok) {
+		return error;
+	}
+
+	if (fieldArchive()->mapList().isModified() && _lgp.fileExists("maplist")) {
+		QByteArray mapListData;
+		if (fieldArchive()->mapList().save(mapListData)){
+			writer.setEntryData("maplist", mapListData);
+		} else {
+			return Invalid;
+		}
+	}
+
+	QMapIterator<QString, TutFilePC *> itTut(fieldArchive()->tuts());
+
+	while (itTut.hasNext()) {
+		itTut.next();
+		TutFile *tut = itTut.value();
+
+		if (tut != nullptr && tut->isModified()) {
+			if (!_lgp.fileExists(itTut.key() + ".tut")) {
+				return FieldNotFound;
+			}
+			writer.setEntryData(itTut.key() + ".tut", tut->save());
+		}
+	}
+
+	if (!writer.hasEntries()) {
+		return Ok;
+	}
+
+	QString path = _lgp.fileName();
+	_lgp.close();
+	bool written;
+	// The in place update is not atomic: opt-in only, an interrupted
+	// save must leave the old archive valid by default
+	if (Config::value("lgpSaveInPlace", false).toBool()) {
+		written = writer.writeInPlace(Config::value("lgpMaxFragmentation", 10).toInt(), &writeObserver);
+		// Full repack when too much space is lost by the in place update
+		if (!written && writer.error() == LgpWriter::FragmentedError) {
+			written = writer.write(path, &writeObserver);
+		}
+	} else {
+		written = writer.write(path, &writeObserver);
+	}
+	_savePeakMemory = writer.peakMemory();
+
+	// The entries moved, the TOC cached by Lgp must be read again
+	_lgp.clear();
+	if (!_lgp.open()) {
+		return ErrorOpening;
+	}
+
+	return written ? Ok : errorCode(writer.error());
+}
+
+FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::errorCode(LgpWriter::Error error)
+{
+	switch (error) {
+	case LgpWriter::NoError:
+		return Ok;
+	case LgpWriter::OpenError:
+		return ErrorOpening;
+	case LgpWriter::OpenTempError:
+		return ErrorOpeningTemp;
+	case LgpWriter::CopyError:
+		return ErrorCopying;
+	case LgpWriter::RenameError:
+		return ErrorRenaming;
+	case LgpWriter::AbortError:
+		return Aborted;
+	default:
+		return Invalid;
+	}
+}
+
 FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::save2(const QString &path, ArchiveObserver *observer)
 {
 	if (!_lgp.isOpen() && !_lgp.open()) {
 		return ErrorOpening;
 	}
+
+	// Same file list: unchanged entries are copied raw
+	if (canStreamSave(path)) {
+		return streamSave(observer);
+	}
+
 	FieldArchiveIterator it(*(fieldArchive()));
 
 	while (it.hasNext()) {
@@ -158,31 +340,46 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::save2(const QString &path, Archiv
 			return Aborted;
 		}
 		Field *field = it.next(false);
-		if (field && field->isOpen() && field->isModified()) {
-			if (field->isRenamed()) {
-				if (_lgp.fileExists(field->name())) {
-					_lgp.removeFile(field->name());
-				}
-
-				if (_lgp.fileExists(field->oldName())) {
-					if (!_lgp.renameFile(field->oldName(), field->name())) {
-						qDebug() << "Cannot rename" << field->oldName() << field->name();
-						return ErrorOpening;
-					}
-				}
-				
+		if (field && field->isOpen() && field->isModified() && field->isRenamed()) {
+			if (_lgp.fileExists(field->name())) {
+				_lgp.removeFile(field->name());
 			}
 
-			if (_lgp.fileExists(field->name())) {
-				if (!_lgp.setFile(field->name(), new FieldSaveIO(field))) {
-					qDebug() << "Cannot set file" << field->name();
+			if (_lgp.fileExists(field->oldName())) {
+				if (!_lgp.renameFile(field->oldName(), field->name())) {
+					qDebug() << "Cannot rename" << field->oldName() << field->name();
 					return ErrorOpening;
 				}
-			} else if (!_lgp.addFile(field->name(), new FieldSaveIO(field))) {
+			}
+		}
+	}
+
+	if (observer) {
+		observer->setObserverMaximum(100);
+	}
+	ArchiveObserverRange fieldsObserver(observer, 0, 30), packObserver(observer, 30, 100);
+
+	// Fields are compressed before packing, in parallel
+	ErrorCode error = saveModifiedFields(serializeField,
+	                                     [this](Field *field, const QList<QByteArray> &files) {
+		if (_lgp.fileExists(field->name())) {
+			if (!_lgp.setFileData(field->name(), files.first())) {
+				qDebug() << "Cannot set file" << field->name();
+				return ErrorOpening;
+			}
+		} else {
+			QBuffer *buffer = new QBuffer();
+			buffer->setData(files.first());
+			if (!_lgp.addFile(field->name(), buffer)) {
 				qDebug() << "Cannot add file" << field->name();
 				return ErrorOpening;
 			}
 		}
+		return Ok;
+	}, &fieldsObserver);
+
+	if (error != Ok) {
+		return error;
 	}
 
 	if (fieldArchive()->mapList().isModified() && _lgp.fileExists("maplist")) {
@@ -207,11 +404,11 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::save2(const QString &path, Archiv
 		}
 	}
 
-	this->observer = observer;
-
-	if (!_lgp.pack(path, this)) {
-		this->observer = nullptr;
+	this->observer = &packObserver;
+	bool packed = _lgp.pack(path, this);
+	this->observer = nullptr;
 
+	if (!packed) {
 		switch (_lgp.error()) {
 		case Lgp::OpenError:
 			return ErrorOpening;
@@ -237,7 +434,7 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPCLgp::save2(const QString &path, Archiv
 		return ErrorOpening;
 	}
 
-	this->observer = nullptr;
+	_filesAdded = false;
 
 	return Ok;
 }
@@ -267,6 +464,12 @@ QByteArray FieldArchiveIOPCFile::fieldData2(Field *field, const QString &extensi
 QByteArray FieldArchiveIOPCFile::fileData2(const QString &fileName)
 {
 	Q_UNUSED(fileName)
+	if (isMemoryMapped()) {
+		QByteArray data = mappedFileData(fic.fileName());
+		if (!data.isNull()) {
+			return data;
+		}
+	}
 	if (!fic.isOpen() && !fic.open(QIODevice::ReadOnly))		return QByteArray();
 	fic.reset();
 	QByteArray data = fic.readAll();
@@ -349,6 +552,13 @@ QByteArray FieldArchiveIOPCDir::fieldData2(Field *field, const QString &extensio
 
 QByteArray FieldArchiveIOPCDir::fileData2(const QString &fileName)
 {
+	if (isMemoryMapped()) {
+		QByteArray data = mappedFileData(dir.filePath(fileName));
+		if (!data.isNull()) {
+			return data;
+		}
+	}
+
 	QByteArray data;
 
 	QFile f(dir.filePath(fileName));
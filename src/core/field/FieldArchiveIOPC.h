@@ -20,6 +20,7 @@
 #include <QLockedFile>
 #include <Lgp>
 #include "FieldArchiveIO.h"
+#include "core/LgpWriter.h"
 
 class FieldArchivePC;
 
@@ -49,6 +50,9 @@ public:
 	QString path() const override;
 
 	Archive *device() override;
+	inline qint64 savePeakMemory() const override {
+		return _savePeakMemory;
+	}
 
 	void setObserverValue(int value) override {
 		if (observer) {
@@ -69,12 +73,21 @@ public:
 private:
 	QByteArray fieldData2(Field *field, const QString &extension, bool unlzs) override;
 	QByteArray fileData2(const QString &fileName) override;
+	QByteArray mappedLgpFileData(const QString &fileName);
+	void unmapFiles() override;
 
 	ErrorCode open2(ArchiveObserver *observer) override;
 	ErrorCode save2(const QString &path, ArchiveObserver *observer) override;
+	bool canStreamSave(const QString &path);
+	ErrorCode streamSave(ArchiveObserver *observer);
+	static ErrorCode errorCode(LgpWriter::Error error);
 
 	::Lgp _lgp;
 	ArchiveObserver *observer;
+	// File name -> (data position, size) in the mapped archive
+	QHash<QString, QPair<qint64, qint64>> _mappedToc;
+	qint64 _savePeakMemory;
+	bool _filesAdded;
 };
 
 class FieldArchiveIOPCFile : public FieldArchiveIOPC
@@ -22,11 +22,6 @@
 #include <GZIP>
 #include "Data.h"
 
-QByteArray FieldArchiveIOPS::mimDataCache;
-QByteArray FieldArchiveIOPS::modelDataCache;
-Field *FieldArchiveIOPS::mimCache = nullptr;
-Field *FieldArchiveIOPS::modelCache = nullptr;
-
 FieldArchiveIOPS::FieldArchiveIOPS(FieldArchivePS *fieldArchive) :
 	FieldArchiveIO(fieldArchive)
 {
@@ -34,55 +29,48 @@ FieldArchiveIOPS::FieldArchiveIOPS(FieldArchivePS *fieldArchive) :
 
 QByteArray FieldArchiveIOPS::mimData(Field *field, bool unlzs)
 {
+	QByteArray data;
+
 	// use data from the cache
-	if (unlzs && mimDataIsCached(field)) {
-		return mimDataCache;
+	if (unlzs && dataCache().find(field, "MIM", data)) {
+		return data;
 	}
 
-	QByteArray data = mimData2(field, unlzs);
+	data = mimData2(field, unlzs);
 
 	// put decompressed data in the cache
 	if (unlzs && !data.isEmpty()) {
-		mimCache = field;
-		mimDataCache = data;
+		dataCache().insert(field, "MIM", data);
 	}
 	return data;
 }
 
 QByteArray FieldArchiveIOPS::modelData(Field *field, bool unlzs)
 {
+	QByteArray data;
+
 	// use data from the cache
-	if (unlzs && modelDataIsCached(field)) {
-		return modelDataCache;
+	if (unlzs && dataCache().find(field, "BSX", data)) {
+		return data;
 	}
 
-	QByteArray data = modelData2(field, unlzs);
+	data = modelData2(field, unlzs);
 
 	// put decompressed data in the cache
 	if (unlzs && !data.isEmpty()) {
-		modelCache = field;
-		modelDataCache = data;
+		dataCache().insert(field, "BSX", data);
 	}
 	return data;
 }
 
 bool FieldArchiveIOPS::mimDataIsCached(Field *field)
 {
-	return mimCache && mimCache == field;
+	return dataCache().contains(field, "MIM");
 }
 
 bool FieldArchiveIOPS::modelDataIsCached(Field *field)
 {
-	return modelCache && modelCache == field;
-}
-
-void FieldArchiveIOPS::clearCachedData()
-{
-	mimCache = nullptr;
-	modelCache = nullptr;
-	mimDataCache.clear();
-	modelDataCache.clear();
-	FieldArchiveIO::clearCachedData();
+	return dataCache().contains(field, "BSX");
 }
 
 FieldArchivePS *FieldArchiveIOPS::fieldArchive()
@@ -131,6 +119,13 @@ QByteArray FieldArchiveIOPSFile::modelData2(Field *field, bool unlzs)
 
 QByteArray FieldArchiveIOPSFile::fileData2(const QString &fileName)
 {
+	if (isMemoryMapped()) {
+		QByteArray data = mappedFileData(fileName.isEmpty() ? fic.fileName() : fileName);
+		if (!data.isNull()) {
+			return data;
+		}
+	}
+
 	if (!fileName.isEmpty() && fileName != fic.fileName()) {
 		QFile f(fileName);
 		if (!f.open(QIODevice::ReadOnly)) {
@@ -340,57 +335,38 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPSIso::save2(const QString &path0, Archi
 	bool saveAs = QFileInfo(path) != QFileInfo(iso.io());
 
 	if (observer)	observer->setObserverMaximum(100);
+	ArchiveObserverRange fieldsObserver(observer, 0, 20), packObserver(observer, 20, 100);
 
-	// FIELD/*.DAT
+	// FIELD/*.DAT, *.BSX and *.MIM, compressed in parallel before packing
 
-	FieldArchiveIterator it(*(fieldArchive()));
-	while (it.hasNext()) {
-		if (observer && observer->observerWasCanceled()) {
-			return Aborted;
-		}
-		Field *field = it.next(false);
-		if (field && field->isOpen() && field->isModified()) {
-			FieldPS *fieldPS = static_cast<FieldPS *>(field);
-
-			if (fieldPS->isDatModified()) {
-				IsoFile *isoField = isoFieldDirectory->file(field->name().toUpper() + ".DAT");
-				if (isoField != nullptr) {
-					QByteArray newData;
-
-					if (!field->save(newData, true)) {
-						return Invalid;
-					}
-
-					isoField->setModifiedFile(newData);
-				}
-			}
-
-			if (fieldPS->isBsxModified()) {
-				IsoFile *isoFieldBsx = isoFieldDirectory->file(field->name().toUpper() + ".BSX");
-				if (isoFieldBsx != nullptr) {
-					QByteArray newDataBsx;
-
-					if (!fieldPS->saveModels(newDataBsx, true)) {
-						return Invalid;
-					}
-
-					isoFieldBsx->setModifiedFile(newDataBsx);
-				}
-			}
+	ErrorCode error = saveModifiedFields([](Field *field, QList<QByteArray> &files) {
+		FieldPS *fieldPS = static_cast<FieldPS *>(field);
+		QByteArray newData, newDataBsx, newDataMim;
 
-			if (fieldPS->isMimModified()) {
-				IsoFile *isoFieldMim = isoFieldDirectory->file(field->name().toUpper() + ".MIM");
-				if (isoFieldMim != nullptr) {
-					QByteArray newDataMim;
+		if ((fieldPS->isDatModified() && !field->save(newData, true))
+		        || (fieldPS->isBsxModified() && !fieldPS->saveModels(newDataBsx, true))
+		        || (fieldPS->isMimModified() && !fieldPS->saveBackground(newDataMim, true))) {
+			return false;
+		}
 
-					if (!fieldPS->saveBackground(newDataMim, true)) {
-						return Invalid;
-					}
+		files << newData << newDataBsx << newDataMim;
+		return true;
+	}, [this](Field *field, const QList<QByteArray> &files) {
+		const QStringList extensions = {".DAT", ".BSX", ".MIM"};
 
-					isoFieldMim->setModifiedFile(newDataMim);
+		for (int i = 0; i < extensions.size(); ++i) {
+			if (!files.at(i).isEmpty()) {
+				IsoFile *isoField = isoFieldDirectory->file(field->name().toUpper() + extensions.at(i));
+				if (isoField != nullptr) {
+					isoField->setModifiedFile(files.at(i));
 				}
 			}
 		}
+		return Ok;
+	}, &fieldsObserver);
+
+	if (error != Ok) {
+		return error;
 	}
 
 	IsoArchive isoTemp(path % ".makoutemp");
@@ -398,7 +374,10 @@ FieldArchiveIO::ErrorCode FieldArchiveIOPSIso::save2(const QString &path0, Archi
 		return ErrorOpening;
 	}
 
-	if (!iso.pack(&isoTemp, observer, isoFieldDirectory)) {
+	// In percent, unless pack() changes it
+	packObserver.setObserverMaximum(100);
+
+	if (!iso.pack(&isoTemp, &packObserver, isoFieldDirectory)) {
 		if (observer && observer->observerWasCanceled()) {
 			return Aborted;
 		}
@@ -488,6 +467,13 @@ QByteArray FieldArchiveIOPSDir::modelData2(Field *field, bool unlzs)
 
 QByteArray FieldArchiveIOPSDir::fileData2(const QString &fileName)
 {
+	if (isMemoryMapped()) {
+		QByteArray data = mappedFileData(dir.filePath(fileName.toUpper()));
+		if (!data.isNull()) {
+			return data;
+		}
+	}
+
 	QByteArray data;
 
 	QFile f(dir.filePath(fileName.toUpper()));
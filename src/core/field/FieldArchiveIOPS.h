@@ -34,15 +34,11 @@ public:
 
 	static bool mimDataIsCached(Field *field);
 	static bool modelDataIsCached(Field *field);
-	void clearCachedData() override;
 protected:
 	virtual QByteArray mimData2(Field *field, bool unlzs)=0;
 	virtual QByteArray modelData2(Field *field, bool unlzs)=0;
 
 	FieldArchivePS *fieldArchive();
-private:
-	static QByteArray mimDataCache, modelDataCache;
-	static Field *mimCache, *modelCache;
 };
 
 class FieldArchiveIOPSFile : public FieldArchiveIOPS
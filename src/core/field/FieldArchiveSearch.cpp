@@ -0,0 +1,235 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "FieldArchiveSearch.h"
+#include "core/Parallel.h"
+
+FieldArchiveSearch::FieldArchiveSearch(FieldArchive *fieldArchive) :
+    _fieldArchive(fieldArchive), _query(nullptr), _type(SearchOpcode),
+    _jobCount(fieldArchive->jobCount()), _canceled(0)
+{
+}
+
+FieldArchiveSearch::~FieldArchiveSearch()
+{
+	delete _query;
+}
+
+void FieldArchiveSearch::setQuery(Type type, SearchQuery *query)
+{
+	delete _query;
+	_type = type;
+	_query = query;
+}
+
+void FieldArchiveSearch::setOpcode(int opcode)
+{
+	setQuery(SearchOpcode, new SearchOpcodeQuery(opcode));
+}
+
+void FieldArchiveSearch::setVar(quint8 bank, quint16 address, Opcode::Operation op, int value)
+{
+	setQuery(SearchVar, new SearchVarQuery(bank, address, op, value));
+}
+
+void FieldArchiveSearch::setExec(quint8 group, quint8 script)
+{
+	setQuery(SearchExec, new SearchExecQuery(group, script));
+}
+
+void FieldArchiveSearch::setMapJump(int map)
+{
+	setQuery(SearchMapJump, new SearchFieldQuery(map));
+}
+
+void FieldArchiveSearch::setTextInScripts(const QRegularExpression &text)
+{
+	setQuery(SearchTextInScripts, new SearchTextQuery(text));
+}
+
+void FieldArchiveSearch::setText(const QRegularExpression &text)
+{
+	setQuery(SearchText, new SearchTextQuery(text));
+}
+
+bool FieldArchiveSearch::findAll(const std::function<bool (int mapID, const QList<SearchResult> &)> &collect)
+{
+	if (_query == nullptr) {
+		return false;
+	}
+
+	QList<int> mapIDs;
+	QList<Field *> fields;
+	FieldArchiveIterator it(*_fieldArchive);
+
+	quint32 key = indexKey();
+	// An opcode id is matched exactly by its key, indexed fields
+	// are answered from the index without being opened
+	bool fromIndex = _type == SearchOpcode;
+	QHash<int, QList<SearchResult>> indexedResults;
+
+	// Fields known not to match are not even opened
+	while (it.hasNext()) {
+		Field *f = it.next(false);
+		if (f == nullptr || !_fieldArchive->scriptsMayContain(f, it.mapId(), key)) {
+			continue;
+		}
+		if (fromIndex && _fieldArchive->scriptIndex().contains(it.mapId())) {
+			indexedResults.insert(it.mapId(), QList<SearchResult>());
+			fields.append(nullptr);
+		} else {
+			fields.append(f);
+		}
+		mapIDs.append(it.mapId());
+	}
+
+	if (!indexedResults.isEmpty()) {
+		const QList<ScriptIndexPosting> postings = _fieldArchive->scriptIndex().postings(key);
+		SearchResult result;
+		result.textID = 0;
+		result.index = result.size = 0;
+
+		for (const ScriptIndexPosting &posting : postings) {
+			auto resultsIt = indexedResults.find(posting.mapID);
+			if (resultsIt != indexedResults.end()) {
+				result.mapID = posting.mapID;
+				result.groupID = posting.groupID;
+				result.scriptID = posting.scriptID;
+				result.opcodeID = posting.opcodeID;
+				resultsIt->append(result);
+			}
+		}
+	}
+
+	std::vector< QList<SearchResult> > results(size_t(fields.size()));
+
+	return Parallel::orderedFor(fields.size(), _jobCount, [&](qsizetype i) {
+		if (!wasCanceled() && fields.at(i) != nullptr) {
+			results[size_t(i)] = findAll(mapIDs.at(i), fields.at(i));
+		}
+	}, [&](qsizetype i) {
+		if (wasCanceled()) {
+			return false;
+		}
+		QList<SearchResult> fieldResults;
+		if (fields.at(i) == nullptr) {
+			fieldResults = indexedResults.take(mapIDs.at(i));
+		} else {
+			if (key != ScriptIndex::NoKey) {
+				_fieldArchive->indexScripts(fields.at(i), mapIDs.at(i));
+			}
+			fieldResults = std::move(results[size_t(i)]);
+		}
+		return fieldResults.isEmpty() || collect(mapIDs.at(i), fieldResults);
+	});
+}
+
+quint32 FieldArchiveSearch::indexKey() const
+{
+	switch (_type) {
+	case SearchOpcode:
+		return ScriptIndex::opcodeKey(static_cast<const SearchOpcodeQuery *>(_query)->opcode);
+	case SearchVar: {
+		const SearchVarQuery *query = static_cast<const SearchVarQuery *>(_query);
+		return ScriptIndex::varKey(query->bank, query->address);
+	}
+	case SearchExec: {
+		const SearchExecQuery *query = static_cast<const SearchExecQuery *>(_query);
+		return ScriptIndex::execKey(query->group, query->script);
+	}
+	case SearchMapJump:
+		return ScriptIndex::mapJumpKey(quint16(static_cast<const SearchFieldQuery *>(_query)->mapID));
+	case SearchTextInScripts:
+	case SearchText:
+		break;
+	}
+
+	return ScriptIndex::NoKey;
+}
+
+QList<SearchResult> FieldArchiveSearch::findAll(int mapID, Field *field) const
+{
+	QList<SearchResult> ret;
+
+	if (!field->isOpen() && !field->open()) {
+		return ret;
+	}
+
+	Section1File *section1 = field->scriptsAndTexts();
+	if (!section1->isOpen()) {
+		return ret;
+	}
+
+	SearchResult result;
+	result.mapID = mapID;
+	result.groupID = result.scriptID = result.opcodeID = 0;
+	result.textID = 0;
+	result.index = result.size = 0;
+
+	if (_type == SearchText) {
+		const SearchTextQuery *query = static_cast<const SearchTextQuery *>(_query);
+
+		while (section1->searchText(query->text, result.textID, result.index, result.size)) {
+			ret.append(result);
+			++result.index;
+		}
+
+		return ret;
+	}
+
+	forever {
+		bool found = false;
+
+		switch (_type) {
+		case SearchOpcode:
+			found = section1->searchOpcode(static_cast<const SearchOpcodeQuery *>(_query)->opcode,
+			                               result.groupID, result.scriptID, result.opcodeID);
+			break;
+		case SearchVar: {
+			const SearchVarQuery *query = static_cast<const SearchVarQuery *>(_query);
+			found = section1->searchVar(query->bank, query->address, query->op, query->value,
+			                            result.groupID, result.scriptID, result.opcodeID);
+		}
+			break;
+		case SearchExec: {
+			const SearchExecQuery *query = static_cast<const SearchExecQuery *>(_query);
+			found = section1->searchExec(query->group, query->script,
+			                             result.groupID, result.scriptID, result.opcodeID);
+		}
+			break;
+		case SearchMapJump:
+			found = section1->searchMapJump(quint16(static_cast<const SearchFieldQuery *>(_query)->mapID),
+			                                result.groupID, result.scriptID, result.opcodeID);
+			break;
+		case SearchTextInScripts:
+			found = section1->searchTextInScripts(static_cast<const SearchTextQuery *>(_query)->text,
+			                                      result.groupID, result.scriptID, result.opcodeID);
+			break;
+		case SearchText:
+			break;
+		}
+
+		if (!found || wasCanceled()) {
+			break;
+		}
+
+		ret.append(result);
+		++result.opcodeID;
+	}
+
+	return ret;
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include "FieldArchive.h"
+
+struct SearchResult
+{
+	int mapID;
+	int groupID, scriptID, opcodeID; // Script searches
+	int textID;                      // Text searches
+	qsizetype index, size;
+};
+
+/*
+ * Archive-wide "find all": fields are opened and searched on a
+ * worker pool, results are reported field by field, in map order.
+ * The script index skips fields that cannot match, and answers
+ * opcode searches directly for the fields it already knows.
+ */
+class FieldArchiveSearch
+{
+public:
+	enum Type {
+		SearchOpcode, SearchVar, SearchExec,
+		SearchMapJump, SearchTextInScripts, SearchText
+	};
+
+	explicit FieldArchiveSearch(FieldArchive *fieldArchive);
+	virtual ~FieldArchiveSearch();
+
+	void setOpcode(int opcode);
+	void setVar(quint8 bank, quint16 address, Opcode::Operation op, int value);
+	void setExec(quint8 group, quint8 script);
+	void setMapJump(int map);
+	void setTextInScripts(const QRegularExpression &text);
+	void setText(const QRegularExpression &text);
+	inline Type type() const {
+		return _type;
+	}
+
+	inline void setJobCount(int jobCount) {
+		_jobCount = jobCount;
+	}
+	// Can be called from any thread
+	inline void cancel() {
+		_canceled.storeRelaxed(1);
+	}
+	inline bool wasCanceled() const {
+		return _canceled.loadRelaxed() != 0;
+	}
+
+	// collect is called on the calling thread, returns false to stop
+	bool findAll(const std::function<bool (int mapID, const QList<SearchResult> &)> &collect);
+	QList<SearchResult> findAll(int mapID, Field *field) const;
+private:
+	void setQuery(Type type, SearchQuery *query);
+	quint32 indexKey() const;
+
+	FieldArchive *_fieldArchive;
+	SearchQuery *_query;
+	Type _type;
+	int _jobCount;
+	QAtomicInt _canceled;
+};
@@ -0,0 +1,213 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "FieldDataCache.h"
+
+FieldDataCache::FieldDataCache(qsizetype maxCost) :
+	_maxCost(maxCost), _cost(0), _tick(0),
+	_hits(0), _misses(0), _evictions(0)
+{
+}
+
+bool FieldDataCache::contains(const Field *field, const QString &extension) const
+{
+	QMutexLocker locker(&_mutex);
+	return _entries.contains(Key(field, extension));
+}
+
+bool FieldDataCache::find(const Field *field, const QString &extension, QByteArray &data)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _entries.find(Key(field, extension));
+
+	if (it == _entries.end()) {
+		++_misses;
+		return false;
+	}
+
+	++_hits;
+	it->lastUse = ++_tick;
+	data = it->data;
+
+	return true;
+}
+
+void FieldDataCache::insert(const Field *field, const QString &extension, const QByteArray &data)
+{
+	QMutexLocker locker(&_mutex);
+	Key key(field, extension);
+	auto it = _entries.find(key);
+
+	if (it != _entries.end()) {
+		_cost -= it->data.size();
+		_entries.erase(it);
+	}
+	removeDecoder(key);
+
+	if (data.isEmpty() || data.size() > _maxCost) {
+		return;
+	}
+
+	evict(_maxCost - data.size());
+
+	Entry entry;
+	entry.data = data;
+	entry.lastUse = ++_tick;
+	_entries.insert(key, entry);
+	_cost += data.size();
+}
+
+bool FieldDataCache::takeDecoder(const Field *field, const QString &extension, LzsDecoder &decoder)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _decoders.find(Key(field, extension));
+
+	if (it == _decoders.end()) {
+		return false;
+	}
+
+	decoder = it->decoder;
+	_cost -= decoder.cost();
+	_decoders.erase(it);
+
+	return true;
+}
+
+void FieldDataCache::putDecoder(const Field *field, const QString &extension, const LzsDecoder &decoder)
+{
+	QMutexLocker locker(&_mutex);
+	Key key(field, extension);
+
+	removeDecoder(key);
+
+	// Useless when the whole data is known
+	if (_entries.contains(key) || decoder.cost() > _maxCost) {
+		return;
+	}
+
+	evict(_maxCost - decoder.cost());
+
+	DecoderEntry entry;
+	entry.decoder = decoder;
+	entry.lastUse = ++_tick;
+	_decoders.insert(key, entry);
+	_cost += decoder.cost();
+}
+
+void FieldDataCache::removeDecoder(const Key &key)
+{
+	auto it = _decoders.find(key);
+
+	if (it != _decoders.end()) {
+		_cost -= it->decoder.cost();
+		_decoders.erase(it);
+	}
+}
+
+void FieldDataCache::remove(const Field *field)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _entries.begin();
+
+	while (it != _entries.end()) {
+		if (it.key().first == field) {
+			_cost -= it->data.size();
+			it = _entries.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	auto decoderIt = _decoders.begin();
+
+	while (decoderIt != _decoders.end()) {
+		if (decoderIt.key().first == field) {
+			_cost -= decoderIt->decoder.cost();
+			decoderIt = _decoders.erase(decoderIt);
+		} else {
+			++decoderIt;
+		}
+	}
+}
+
+void FieldDataCache::clear()
+{
+	QMutexLocker locker(&_mutex);
+	_entries.clear();
+	_decoders.clear();
+	_cost = 0;
+}
+
+qsizetype FieldDataCache::maxCost() const
+{
+	QMutexLocker locker(&_mutex);
+	return _maxCost;
+}
+
+void FieldDataCache::setMaxCost(qsizetype maxCost)
+{
+	QMutexLocker locker(&_mutex);
+	_maxCost = maxCost;
+	evict(maxCost);
+}
+
+FieldDataCache::Stats FieldDataCache::stats() const
+{
+	QMutexLocker locker(&_mutex);
+	Stats ret;
+	ret.hits = _hits;
+	ret.misses = _misses;
+	ret.evictions = _evictions;
+	ret.cost = _cost;
+	ret.count = _entries.size() + _decoders.size();
+
+	return ret;
+}
+
+void FieldDataCache::resetStats()
+{
+	QMutexLocker locker(&_mutex);
+	_hits = _misses = _evictions = 0;
+}
+
+void FieldDataCache::evict(qsizetype maxCost)
+{
+	// Remove the least recently used entries until we fit in maxCost
+	while (_cost > maxCost && (!_entries.isEmpty() || !_decoders.isEmpty())) {
+		auto oldest = _entries.begin();
+		for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+			if (it->lastUse < oldest->lastUse) {
+				oldest = it;
+			}
+		}
+		auto oldestDecoder = _decoders.begin();
+		for (auto it = _decoders.begin(); it != _decoders.end(); ++it) {
+			if (it->lastUse < oldestDecoder->lastUse) {
+				oldestDecoder = it;
+			}
+		}
+		if (oldestDecoder != _decoders.end()
+		        && (oldest == _entries.end() || oldestDecoder->lastUse < oldest->lastUse)) {
+			_cost -= oldestDecoder->decoder.cost();
+			_decoders.erase(oldestDecoder);
+		} else {
+			_cost -= oldest->data.size();
+			_entries.erase(oldest);
+		}
+		++_evictions;
+	}
+}
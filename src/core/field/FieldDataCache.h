@@ -0,0 +1,78 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include "core/LzsDecoder.h"
+
+class Field;
+
+/*
+ * Bounded LRU cache for decompressed field files,
+ * keyed by (field, extension). The total size of the cached data
+ * never exceeds maxCost() bytes (except for a single entry bigger than
+ * the budget, which is not cached at all).
+ * Partially decompressed files are kept as decoder states in the same
+ * budget, so the decompression can be resumed later.
+ */
+class FieldDataCache
+{
+public:
+	struct Stats {
+		quint64 hits, misses, evictions;
+		qsizetype cost;
+		qsizetype count;
+	};
+
+	static constexpr qsizetype DefaultMaxCost = 32 * 1024 * 1024;
+
+	explicit FieldDataCache(qsizetype maxCost = DefaultMaxCost);
+
+	bool contains(const Field *field, const QString &extension) const;
+	bool find(const Field *field, const QString &extension, QByteArray &data);
+	void insert(const Field *field, const QString &extension, const QByteArray &data);
+	// The decoder is removed from the cache until putDecoder() is called
+	bool takeDecoder(const Field *field, const QString &extension, LzsDecoder &decoder);
+	void putDecoder(const Field *field, const QString &extension, const LzsDecoder &decoder);
+	void remove(const Field *field);
+	void clear();
+
+	qsizetype maxCost() const;
+	void setMaxCost(qsizetype maxCost);
+	Stats stats() const;
+	void resetStats();
+private:
+	typedef QPair<const Field *, QString> Key;
+	struct Entry {
+		QByteArray data;
+		quint64 lastUse;
+	};
+	struct DecoderEntry {
+		LzsDecoder decoder;
+		quint64 lastUse;
+	};
+
+	void evict(qsizetype maxCost);
+	void removeDecoder(const Key &key);
+
+	QHash<Key, Entry> _entries;
+	QHash<Key, DecoderEntry> _decoders;
+	qsizetype _maxCost, _cost;
+	quint64 _tick, _hits, _misses, _evictions;
+	mutable QMutex _mutex;
+};
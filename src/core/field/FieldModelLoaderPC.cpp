@@ -118,10 +118,12 @@ void FieldModelLoaderPC::initEmpty()
 
 bool FieldModelLoaderPC::open()
 {
-	return open(field()->sectionData(Field::ModelLoader));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::ModelLoader, buffer));
 }
 
-bool FieldModelLoaderPC::open(const QByteArray &data)
+bool FieldModelLoaderPC::open(QByteArrayView data)
 {
 	const char *constData = data.constData();
 
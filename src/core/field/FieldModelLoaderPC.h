@@ -39,7 +39,7 @@ public:
 	void clean();
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	qsizetype modelCount() const override;
 	bool insertModel(int modelID, const QString &hrcName);
@@ -34,10 +34,12 @@ void FieldModelLoaderPS::clear()
 
 bool FieldModelLoaderPS::open()
 {
-	return open(field()->sectionData(Field::ModelLoader));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::ModelLoader, buffer));
 }
 
-bool FieldModelLoaderPS::open(const QByteArray &data)
+bool FieldModelLoaderPS::open(QByteArrayView data)
 {
 	const char *constData = data.constData();
 
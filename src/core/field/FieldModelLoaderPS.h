@@ -35,7 +35,7 @@ public:
 	explicit FieldModelLoaderPS(Field *field);
 	void clear() override;
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	qsizetype modelCount() const override;
 	qsizetype animCount(int modelID) const override;
@@ -43,7 +43,7 @@ FieldPC::~FieldPC()
 	}
 }
 
-void FieldPC::openHeader(const QByteArray &fileData)
+void FieldPC::openHeader(QByteArrayView fileData)
 {
 	memcpy(sectionPositions, fileData.constData() + 6, 9 * 4); // header
 }
@@ -39,7 +39,7 @@ public:
 	bool exportToChunks(const QDir &dir) override;
 protected:
 	inline int headerSize() const override { return 42; }
-	void openHeader(const QByteArray &fileData) override;
+	void openHeader(QByteArrayView fileData) override;
 	QByteArray saveHeader() const override;
 	QByteArray saveFooter() const override;
 	FieldPart *createPart(FieldSection part) override;
@@ -15,11 +15,11 @@
  ** You should have received a copy of the GNU General Public License
  ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
  ****************************************************************************/
-#include <LZS>
 #include "FieldPS.h"
 #include "FieldPC.h"
 #include "BackgroundFilePS.h"
 #include "BackgroundFilePC.h"
+#include "core/LzsEncoder.h"
 
 FieldPS::FieldPS(const QString &name, FieldArchiveIO *io) :
       Field(name, io), vramDiff(0)
@@ -40,7 +40,7 @@ FieldPS::~FieldPS()
 	}
 }
 
-void FieldPS::openHeader(const QByteArray &fileData)
+void FieldPS::openHeader(QByteArrayView fileData)
 {
 	memcpy(sectionPositions, fileData.constData(), headerSize()); // header
 	vramDiff = sectionPositions[0] - headerSize();// vram section1 pos - real section 1 pos
@@ -202,9 +202,7 @@ bool FieldPS::saveModels(QByteArray &newData, bool compress)
 	newData = ioBsx.data();
 
 	if (compress) {
-		const QByteArray &compresse = LZS::compress(newData);
-		quint32 lzsSize = quint32(compresse.size());
-		newData = QByteArray((char *)&lzsSize, 4).append(compresse);
+		newData = LzsEncoder::compressWithHeader(newData);
 	}
 
 	return true;
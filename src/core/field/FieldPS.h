@@ -45,7 +45,7 @@ public:
 	bool isMimModified() const;
 protected:
 	inline virtual int headerSize() const override { return 28; }
-	virtual void openHeader(const QByteArray &fileData) override;
+	virtual void openHeader(QByteArrayView fileData) override;
 	virtual QByteArray saveHeader() const override;
 	virtual QByteArray saveFooter() const override;
 	virtual FieldPart *createPart(FieldSection part) override;
@@ -28,7 +28,7 @@ FieldPSDemo::FieldPSDemo(const Field &field) :
 {
 }
 
-void FieldPSDemo::openHeader(const QByteArray &fileData)
+void FieldPSDemo::openHeader(QByteArrayView fileData)
 {
 	Q_UNUSED(fileData)
 }
@@ -28,7 +28,7 @@ public:
 
 protected:
 	inline int headerSize() const override { return 0; }
-	void openHeader(const QByteArray &fileData) override;
+	void openHeader(QByteArrayView fileData) override;
 	FieldPart *createPart(FieldSection part) override;
 	int sectionId(FieldSection part) const override;
 	QString sectionFile(FieldSection part) const override;
@@ -29,7 +29,7 @@ public:
 
 	virtual void initEmpty() {}
 	virtual bool open()=0;
-	virtual bool open(const QByteArray &data)=0;
+	virtual bool open(QByteArrayView data)=0;
 	virtual QByteArray save() const=0;
 	virtual bool canSave() const;
 	virtual void close();
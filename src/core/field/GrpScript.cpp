@@ -52,6 +52,7 @@ GrpScript GrpScript::createGroupModel(quint8 modelID, qint16 charID)
 
 void GrpScript::setScript(int row, const Script &script)
 {
+	openScripts();
 	_scripts[row] = script;
 
 	if (row == 0) {
@@ -59,14 +60,56 @@ void GrpScript::setScript(int row, const Script &script)
 	}
 }
 
-void GrpScript::detectType()
+void GrpScript::setScriptsData(const QByteArray &data, const QList<quint16> &positions)
+{
+	_scriptsData = data;
+	_scriptsPositions = positions;
+}
+
+void GrpScript::decodeScripts() const
+{
+	const char *constData = _scriptsData.constData();
+	qsizetype scriptCount = _scriptsPositions.size() - 1;
+	quint8 scriptID = 0;
+
+	for (quint8 j = 0; j < scriptCount; ++j) {
+		quint16 position = _scriptsPositions.at(j),
+		        nextPosition = _scriptsPositions.at(j + 1);
+
+		if (nextPosition > position && nextPosition <= _scriptsData.size()) {
+			Script script(constData + position, nextPosition - position);
+			if (!script.isValid()) {
+				qWarning() << "GrpScript::decodeScripts invalid script" << _name << j;
+			}
+			if (scriptID == 0) {
+				Script scriptMain = script.splitScriptAtReturn();
+				script.pack();
+				scriptMain.pack();
+				_scripts[0] = script; // S0 - Init
+				_scripts[1] = scriptMain; // S0 - Main
+			} else {
+				script.pack();
+				_scripts[scriptID + 1] = script;
+			}
+			scriptID = j + 1;
+		}
+	}
+
+	_scriptsData = QByteArray();
+	detectType();
+}
+
+void GrpScript::detectType() const
 {
 	_character = -1;
 	_type = NoType;
 	
 	const Script &firstScript = _scripts.at(0);
+	Opcode decoded;
+	qsizetype count = firstScript.size();
 	
-	for (const Opcode &opcode : firstScript.opcodes()) {
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = firstScript.opcodeAt(i, decoded);
 		switch (opcode.id()) {
 		case OpcodeKey::PC: // Character definition
 			_character = opcode.op().opcodePC.charID;
@@ -101,11 +144,13 @@ void GrpScript::detectType()
 
 void GrpScript::backgroundParams(QHash<quint8, quint8> &paramActifs) const
 {
+	openScripts();
 	_scripts.first().backgroundParams(paramActifs);
 }
 
 void GrpScript::backgroundMove(qint16 z[2], qint16 *x, qint16 *y) const
 {
+	openScripts();
 	for (const Script &script : _scripts) {
 		script.backgroundMove(z, x, y);
 	}
@@ -118,6 +163,7 @@ QString GrpScript::name() const
 
 QList<Script> GrpScript::scriptToList() const
 {
+	openScripts();
 	QList<Script> ret;
 	ret.reserve(33);
 
@@ -130,6 +176,7 @@ QList<Script> GrpScript::scriptToList() const
 
 QByteArray GrpScript::toByteArray(quint8 scriptID) const
 {
+	openScripts();
 	if (scriptID == 0) {
 		if (!_scripts.at(0).isEmpty()) {
 			return _scripts.at(0).toByteArray() + _scripts.at(1).toByteArray();
@@ -237,6 +284,7 @@ bool GrpScript::search(int &scriptID, int &opcodeID) const
 
 bool GrpScript::searchOpcode(int opcode, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!search(scriptID, opcodeID)) {
 		return false;
 	}
@@ -250,6 +298,7 @@ bool GrpScript::searchOpcode(int opcode, int &scriptID, int &opcodeID) const
 
 bool GrpScript::searchVar(quint8 bank, quint16 address, Opcode::Operation op, int value, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!search(scriptID, opcodeID)) {
 		return false;
 	}
@@ -263,6 +312,7 @@ bool GrpScript::searchVar(quint8 bank, quint16 address, Opcode::Operation op, in
 
 void GrpScript::searchAllVars(QList<FF7Var> &vars) const
 {
+	openScripts();
 	for (const Script &script : _scripts) {
 		script.searchAllVars(vars);
 	}
@@ -270,6 +320,7 @@ void GrpScript::searchAllVars(QList<FF7Var> &vars) const
 
 bool GrpScript::searchExec(quint8 group, quint8 script, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!search(scriptID, opcodeID)) {
 		return false;
 	}
@@ -283,6 +334,7 @@ bool GrpScript::searchExec(quint8 group, quint8 script, int &scriptID, int &opco
 
 bool GrpScript::searchMapJump(quint16 map, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!search(scriptID, opcodeID)) {
 		return false;
 	}
@@ -296,6 +348,7 @@ bool GrpScript::searchMapJump(quint16 map, int &scriptID, int &opcodeID) const
 
 bool GrpScript::searchTextInScripts(const QRegularExpression &text, int &scriptID, int &opcodeID, const Section1File *scriptsAndTexts) const
 {
+	openScripts();
 	if (scriptID < 0) {
 		opcodeID = scriptID = 0;
 	}
@@ -322,6 +375,7 @@ bool GrpScript::searchP(int &scriptID, int &opcodeID) const
 
 bool GrpScript::searchOpcodeP(int opcode, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!searchP(scriptID, opcodeID)) {
 		return false;
 	}
@@ -335,6 +389,7 @@ bool GrpScript::searchOpcodeP(int opcode, int &scriptID, int &opcodeID) const
 
 bool GrpScript::searchVarP(quint8 bank, quint16 address, Opcode::Operation op, int value, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!searchP(scriptID, opcodeID)) {
 		return false;
 	}
@@ -348,6 +403,7 @@ bool GrpScript::searchVarP(quint8 bank, quint16 address, Opcode::Operation op, i
 
 bool GrpScript::searchExecP(quint8 group, quint8 script, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!searchP(scriptID, opcodeID)) {
 		return false;
 	}
@@ -361,6 +417,7 @@ bool GrpScript::searchExecP(quint8 group, quint8 script, int &scriptID, int &opc
 
 bool GrpScript::searchMapJumpP(quint16 map, int &scriptID, int &opcodeID) const
 {
+	openScripts();
 	if (!searchP(scriptID, opcodeID)) {
 		return false;
 	}
@@ -374,6 +431,7 @@ bool GrpScript::searchMapJumpP(quint16 map, int &scriptID, int &opcodeID) const
 
 bool GrpScript::searchTextInScriptsP(const QRegularExpression &text, int &scriptID, int &opcodeID, const Section1File *scriptsAndTexts) const
 {
+	openScripts();
 	if (!searchP(scriptID, opcodeID)) {
 		return false;
 	}
@@ -387,6 +445,7 @@ bool GrpScript::searchTextInScriptsP(const QRegularExpression &text, int &script
 
 void GrpScript::listUsedTexts(QSet<quint8> &usedTexts) const
 {
+	openScripts();
 	for (const Script &script : _scripts) {
 		script.listUsedTexts(usedTexts);
 	}
@@ -394,6 +453,7 @@ void GrpScript::listUsedTexts(QSet<quint8> &usedTexts) const
 
 void GrpScript::listUsedTuts(QSet<quint8> &usedTuts) const
 {
+	openScripts();
 	for (const Script &script : _scripts) {
 		script.listUsedTuts(usedTuts);
 	}
@@ -401,6 +461,7 @@ void GrpScript::listUsedTuts(QSet<quint8> &usedTuts) const
 
 void GrpScript::shiftGroupIds(int groupId, int steps)
 {
+	openScripts();
 	for (Script &script : _scripts) {
 		script.shiftGroupIds(groupId, steps);
 	}
@@ -408,6 +469,7 @@ void GrpScript::shiftGroupIds(int groupId, int steps)
 
 void GrpScript::shiftTextIds(int textId, int steps)
 {
+	openScripts();
 	for (Script &script : _scripts) {
 		script.shiftTextIds(textId, steps);
 	}
@@ -415,6 +477,7 @@ void GrpScript::shiftTextIds(int textId, int steps)
 
 void GrpScript::shiftTutIds(int tutId, int steps)
 {
+	openScripts();
 	for (Script &script : _scripts) {
 		script.shiftTutIds(tutId, steps);
 	}
@@ -422,6 +485,7 @@ void GrpScript::shiftTutIds(int tutId, int steps)
 
 void GrpScript::shiftPalIds(int palId, int steps)
 {
+	openScripts();
 	for (Script &script : _scripts) {
 		script.shiftPalIds(palId, steps);
 	}
@@ -429,6 +493,7 @@ void GrpScript::shiftPalIds(int palId, int steps)
 
 void GrpScript::swapGroupIds(int groupId1, int groupId2)
 {
+	openScripts();
 	for (Script &script : _scripts) {
 		script.swapGroupIds(groupId1, groupId2);
 	}
@@ -436,6 +501,7 @@ void GrpScript::swapGroupIds(int groupId1, int groupId2)
 
 void GrpScript::setWindow(const FF7Window &win)
 {
+	openScripts();
 	if (win.scriptID < SCRIPTS_SIZE) {
 		_scripts[win.scriptID].setWindow(win);
 	}
@@ -443,6 +509,7 @@ void GrpScript::setWindow(const FF7Window &win)
 
 void GrpScript::listWindows(int groupID, QMultiMap<quint64, FF7Window> &windows, QMultiMap<quint8, quint64> &text2win) const
 {
+	openScripts();
 	int scriptID = 0;
 	for (const Script &script : _scripts) {
 		script.listWindows(groupID, scriptID++, windows, text2win);
@@ -451,6 +518,7 @@ void GrpScript::listWindows(int groupID, QMultiMap<quint64, FF7Window> &windows,
 
 void GrpScript::listWindows(int groupID, int textID, QList<FF7Window> &windows, int winID) const
 {
+	openScripts();
 	int scriptID = 0;
 	for (const Script &script : _scripts) {
 		script.listWindows(groupID, scriptID++, textID, windows, winID);
@@ -459,17 +527,20 @@ void GrpScript::listWindows(int groupID, int textID, QList<FF7Window> &windows,
 
 void GrpScript::listModelPositions(QList<FF7Position> &positions) const
 {
+	openScripts();
 	_scripts.at(0).listModelPositions(positions);
 	_scripts.at(1).listModelPositions(positions);
 }
 
 bool GrpScript::linePosition(FF7Position position[2]) const
 {
+	openScripts();
 	return _scripts.first().linePosition(position);
 }
 
 bool GrpScript::compile(int &scriptID, int &opcodeID, QString &errorStr)
 {
+	openScripts();
 	scriptID = 0;
 	for (Script &script : _scripts) {
 		if (!script.compile(opcodeID, errorStr)) {
@@ -483,6 +554,7 @@ bool GrpScript::compile(int &scriptID, int &opcodeID, QString &errorStr)
 
 bool GrpScript::removeTexts()
 {
+	openScripts();
 	bool modified = false;
 	for (Script &script : _scripts) {
 		if (script.removeTexts()) {
@@ -495,6 +567,7 @@ bool GrpScript::removeTexts()
 
 QString GrpScript::toString(Section1File *scriptsAndTexts) const
 {
+	openScripts();
 	QString ret(QObject::tr("Group '%1':").arg(name()));
 	int scriptID = 0;
 
@@ -36,6 +36,9 @@ public:
 	static GrpScript createGroupModel(quint8 modelID, qint16 charID = -1);
 
 	void setScript(int row, const Script &script);
+	// The scripts are decoded on first access. positions are the offsets
+	// in data of the scripts of the group, plus the end offset
+	void setScriptsData(const QByteArray &data, const QList<quint16> &positions);
 
 	QString name() const;
 	inline const QString &realName() const {
@@ -45,12 +48,15 @@ public:
 		_name = name;
 	}
 	inline const Script &script(quint8 scriptID) const {
+		openScripts();
 		return _scripts.at(scriptID);
 	}
 	inline Script &script(quint8 scriptID) {
+		openScripts();
 		return _scripts[scriptID];
 	}
 	const QVarLengthArray<Script> &scripts() const {
+		openScripts();
 		return _scripts;
 	}
 	QList<Script> scriptToList() const;
@@ -58,10 +64,12 @@ public:
 	void backgroundParams(QHash<quint8, quint8> &paramActifs) const;
 	void backgroundMove(qint16 z[2], qint16 *x = nullptr, qint16 *y = nullptr) const;
 	inline GrpScript::Type type() const {
+		openScripts();
 		return _type;
 	}
 	QString typeString() const;
 	inline qint16 character() const {
+		openScripts();
 		return _character;
 	}
 	QColor typeColor() const;
@@ -96,14 +104,22 @@ public:
 
 	QString toString(Section1File *scriptsAndTexts) const;
 private:
-	void detectType();
+	inline void openScripts() const {
+		if (!_scriptsData.isNull()) {
+			decodeScripts();
+		}
+	}
+	void decodeScripts() const;
+	void detectType() const;
 	bool search(int &scriptID, int &opcodeID) const;
 
 	QString _name;
-	QVarLengthArray<Script> _scripts;
+	mutable QVarLengthArray<Script> _scripts;
+	mutable QByteArray _scriptsData;
+	QList<quint16> _scriptsPositions;
 
-	Type _type;
-	qint16 _character;
+	mutable Type _type;
+	mutable qint16 _character;
 };
 
 QDataStream &operator<<(QDataStream &stream, const QList<GrpScript> &scripts);
@@ -83,10 +83,12 @@ void IdFile::initEmpty()
 
 bool IdFile::open()
 {
-	return open(field()->sectionData(Field::Walkmesh));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::Walkmesh, buffer));
 }
 
-bool IdFile::open(const QByteArray &data)
+bool IdFile::open(QByteArrayView data)
 {
 	const char *constData = data.constData();
 	quint32 nbSector;
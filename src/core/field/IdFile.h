@@ -39,7 +39,7 @@ public:
 	explicit IdFile(Field *field);
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	void clear() override;
 	bool hasTriangle() const;
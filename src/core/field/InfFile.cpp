@@ -46,10 +46,12 @@ void InfFile::initEmpty()
 
 bool InfFile::open()
 {
-	return open(field()->sectionData(Field::Inf));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::Inf, buffer));
 }
 
-bool InfFile::open(const QByteArray &data)
+bool InfFile::open(QByteArrayView data)
 {
 	qsizetype size = data.size();
 
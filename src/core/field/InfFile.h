@@ -92,7 +92,7 @@ public:
 	explicit InfFile(Field *field);
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	void clear() override;
 	bool isJap() const;
@@ -23,7 +23,8 @@
 #include "FieldArchiveIO.h"
 #include "FieldArchive.h"
 
-Opcode::Opcode() noexcept
+Opcode::Opcode() noexcept :
+    _opcode()
 {
 }
 
@@ -182,48 +183,54 @@ Opcode Opcode::unserialize(const QByteArray &data)
 	return ret;
 }
 
-bool Opcode::isExec() const
+void Opcode::pack(QByteArray &data) const
 {
-	return id() >= OpcodeKey::REQ && id() <= OpcodeKey::PRQEW;
+	data.append(reinterpret_cast<const char *>(&_opcode), qsizetype(structSize()))
+	    .append(resizableData());
 }
 
-bool Opcode::isJump() const
+void Opcode::unpack(const char *data, qsizetype size)
 {
-	return (id() >= OpcodeKey::JMPF && id() <= OpcodeKey::JMPBL)
-	        || id() == OpcodeKey::Unused1B
-	        || isIf();
+	deleteResizableData();
+	memset(&_opcode, 0, sizeof(_opcode));
+	// The size of the structure depends on the id and the sub key
+	memcpy(&_opcode, data, std::min(size_t(size), sizeof(OpcodeSPECIAL)));
+	size_t s = std::min(structSize(), size_t(size));
+	memcpy(&_opcode, data, s);
+	if (qsizetype(s) < size) {
+		setResizableData(QByteArray(data + s, size - qsizetype(s)));
+	}
 }
 
-bool Opcode::isLongJump() const
+size_t Opcode::structSize() const
 {
-	return id() == OpcodeKey::JMPFL
-	        || id() == OpcodeKey::JMPBL
-	        || id() == OpcodeKey::IFUBL
-	        || id() == OpcodeKey::IFSWL
-	        || id() == OpcodeKey::IFUWL
-	        || id() == OpcodeKey::Unused1B;
-}
+	size_t size = id() <= OpcodeKey::LABEL ? info().structSize : sizeof(_opcode);
 
-bool Opcode::isBackJump() const
-{
-	return id() == OpcodeKey::JMPB || id() == OpcodeKey::JMPBL;
-}
+	if (id() == OpcodeKey::SPECIAL) {
+#define op_fun(name) \
+	case OpcodeSpecialKey::name: \
+		size = sizeof(OpcodeSPECIAL##name); \
+		break;
+#define op_sep
 
-bool Opcode::isIf() const
-{
-	return (id() >= OpcodeKey::IFUB && id() <= OpcodeKey::IFUWL)
-	       || (id() >= OpcodeKey::IFKEY && id() <= OpcodeKey::IFKEYOFF)
-	        || (id() >= OpcodeKey::IFPRTYQ && id() <= OpcodeKey::IFMEMBQ);
-}
+		switch (_opcode.opcodeSPECIAL.subKey) {
+		OPCODE_GENERATE_SPECIAL_LIST
+		}
 
-bool Opcode::isVoid() const
-{
-	return id() == OpcodeKey::RET || id() == OpcodeKey::LABEL || isJump();
+#undef op_fun
+#undef op_sep
+	}
+
+	return size;
 }
 
 bool Opcode::searchVar(quint8 bank, quint16 address, Operation operation, int value) const
 {
 	// TODO: compare var with var
+	if (!info().testFlag(OpcodeInfo::Variables)) {
+		return false;
+	}
+
 	const bool noValue = value > 0xFFFF,
 	        noAddress = address > 0xFF;
 	QList<FF7Var> vars;
@@ -1778,6 +1785,10 @@ void Opcode::deleteResizableData()
 
 bool Opcode::variables(QList<FF7Var> &vars) const
 {
+	if (!info().testFlag(OpcodeInfo::Variables)) {
+		return false;
+	}
+
 	qint8 b;
 
 	switch (id()) {
@@ -5286,6 +5297,215 @@ const char *Opcode::operators[OPERATORS_SIZE] = {
     "==", "!=", ">", "<", ">=", "<=", "&", "^", "|", "bitON", "bitOFF"
 };
 
+static constexpr bool opcodeIsIf(OpcodeKey id)
+{
+	return (id >= OpcodeKey::IFUB && id <= OpcodeKey::IFUWL)
+	        || (id >= OpcodeKey::IFKEY && id <= OpcodeKey::IFKEYOFF)
+	        || (id >= OpcodeKey::IFPRTYQ && id <= OpcodeKey::IFMEMBQ);
+}
+
+static constexpr bool opcodeIsJump(OpcodeKey id)
+{
+	return (id >= OpcodeKey::JMPF && id <= OpcodeKey::JMPBL)
+	        || id == OpcodeKey::Unused1B
+	        || opcodeIsIf(id);
+}
+
+// Must match the cases of Opcode::variables()
+static constexpr bool opcodeHasVariables(OpcodeKey id)
+{
+	switch (id) {
+	case OpcodeKey::SPLIT:
+	case OpcodeKey::SPTYE:
+	case OpcodeKey::GTPYE:
+	case OpcodeKey::SPECIAL:
+	case OpcodeKey::IFUB:
+	case OpcodeKey::IFUBL:
+	case OpcodeKey::IFSW:
+	case OpcodeKey::IFSWL:
+	case OpcodeKey::IFUW:
+	case OpcodeKey::IFUWL:
+	case OpcodeKey::BTRLD:
+	case OpcodeKey::NFADE:
+	case OpcodeKey::BGPDH:
+	case OpcodeKey::BGSCR:
+	case OpcodeKey::WNUMB:
+	case OpcodeKey::STTIM:
+	case OpcodeKey::GOLDu:
+	case OpcodeKey::GOLDd:
+	case OpcodeKey::CHGLD:
+	case OpcodeKey::MPARA:
+	case OpcodeKey::MPRA2:
+	case OpcodeKey::MPu:
+	case OpcodeKey::MPd:
+	case OpcodeKey::ASK:
+	case OpcodeKey::HPu:
+	case OpcodeKey::HPd:
+	case OpcodeKey::MENU:
+	case OpcodeKey::GWCOL:
+	case OpcodeKey::SWCOL:
+	case OpcodeKey::STITM:
+	case OpcodeKey::DLITM:
+	case OpcodeKey::CKITM:
+	case OpcodeKey::SMTRA:
+	case OpcodeKey::DMTRA:
+	case OpcodeKey::CMTRA:
+	case OpcodeKey::SHAKE:
+	case OpcodeKey::SCRLC:
+	case OpcodeKey::SCRLA:
+	case OpcodeKey::SCR2D:
+	case OpcodeKey::SCR2DC:
+	case OpcodeKey::SCR2DL:
+	case OpcodeKey::VWOFT:
+	case OpcodeKey::FADE:
+	case OpcodeKey::LSTMP:
+	case OpcodeKey::SCRLP:
+	case OpcodeKey::BATTLE:
+	case OpcodeKey::PGTDR:
+	case OpcodeKey::GETPC:
+	case OpcodeKey::PXYZI:
+	case OpcodeKey::PLUSX:
+	case OpcodeKey::PLUS2X:
+	case OpcodeKey::MINUSX:
+	case OpcodeKey::MINUS2X:
+	case OpcodeKey::INCX:
+	case OpcodeKey::INC2X:
+	case OpcodeKey::DECX:
+	case OpcodeKey::DEC2X:
+	case OpcodeKey::RDMSD:
+	case OpcodeKey::SETBYTE:
+	case OpcodeKey::SETWORD:
+	case OpcodeKey::BITON:
+	case OpcodeKey::BITOFF:
+	case OpcodeKey::BITXOR:
+	case OpcodeKey::PLUS:
+	case OpcodeKey::PLUS2:
+	case OpcodeKey::MINUS:
+	case OpcodeKey::MINUS2:
+	case OpcodeKey::MUL:
+	case OpcodeKey::MUL2:
+	case OpcodeKey::DIV:
+	case OpcodeKey::DIV2:
+	case OpcodeKey::MOD:
+	case OpcodeKey::MOD2:
+	case OpcodeKey::AND:
+	case OpcodeKey::AND2:
+	case OpcodeKey::OR:
+	case OpcodeKey::OR2:
+	case OpcodeKey::XOR:
+	case OpcodeKey::XOR2:
+	case OpcodeKey::INC:
+	case OpcodeKey::INC2:
+	case OpcodeKey::DEC:
+	case OpcodeKey::DEC2:
+	case OpcodeKey::RANDOM:
+	case OpcodeKey::LBYTE:
+	case OpcodeKey::HBYTE:
+	case OpcodeKey::TOBYTE:
+	case OpcodeKey::SETX:
+	case OpcodeKey::GETX:
+	case OpcodeKey::SEARCHX:
+	case OpcodeKey::XYZ:
+	case OpcodeKey::XYZI:
+	case OpcodeKey::XYI:
+	case OpcodeKey::MOVE:
+	case OpcodeKey::CMOVE:
+	case OpcodeKey::FMOVE:
+	case OpcodeKey::MSPED:
+	case OpcodeKey::DIR:
+	case OpcodeKey::TURNGEN:
+	case OpcodeKey::TURN:
+	case OpcodeKey::GETDIR:
+	case OpcodeKey::GETAXY:
+	case OpcodeKey::GETAI:
+	case OpcodeKey::ASPED:
+	case OpcodeKey::JUMP:
+	case OpcodeKey::AXYZI:
+	case OpcodeKey::LADER:
+	case OpcodeKey::OFST:
+	case OpcodeKey::TALKR:
+	case OpcodeKey::SLIDR:
+	case OpcodeKey::TLKR2:
+	case OpcodeKey::SLDR2:
+	case OpcodeKey::SLINE:
+	case OpcodeKey::SIN:
+	case OpcodeKey::COS:
+	case OpcodeKey::AKAO2:
+	case OpcodeKey::MPPAL:
+	case OpcodeKey::BGON:
+	case OpcodeKey::BGOFF:
+	case OpcodeKey::BGROL:
+	case OpcodeKey::BGROL2:
+	case OpcodeKey::BGCLR:
+	case OpcodeKey::STPAL:
+	case OpcodeKey::LDPAL:
+	case OpcodeKey::CPPAL:
+	case OpcodeKey::RTPAL:
+	case OpcodeKey::ADPAL:
+	case OpcodeKey::MPPAL2:
+	case OpcodeKey::CPPAL2:
+	case OpcodeKey::RTPAL2:
+	case OpcodeKey::ADPAL2:
+	case OpcodeKey::SOUND:
+	case OpcodeKey::AKAO:
+	case OpcodeKey::CHMPH:
+	case OpcodeKey::MVIEF:
+	case OpcodeKey::CMUSC:
+	case OpcodeKey::CHMST:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static constexpr OpcodeInfo opcodeInfo(OpcodeKey id, size_t structSize)
+{
+	OpcodeInfo info;
+
+	if (id == OpcodeKey::KAWAI || id == OpcodeKey::Unused1C) {
+		structSize -= sizeof(QByteArray *); // The resizable data is packed after
+	}
+	info.structSize = quint16(structSize);
+
+	if (id >= OpcodeKey::REQ && id <= OpcodeKey::PRQEW) {
+		info.flags |= OpcodeInfo::Exec;
+	}
+	if (opcodeIsJump(id)) {
+		info.flags |= OpcodeInfo::Jump | OpcodeInfo::Void;
+	}
+	if (id == OpcodeKey::JMPFL || id == OpcodeKey::JMPBL
+	        || id == OpcodeKey::IFUBL || id == OpcodeKey::IFSWL
+	        || id == OpcodeKey::IFUWL || id == OpcodeKey::Unused1B) {
+		info.flags |= OpcodeInfo::LongJump;
+	}
+	if (id == OpcodeKey::JMPB || id == OpcodeKey::JMPBL) {
+		info.flags |= OpcodeInfo::BackJump;
+	}
+	if (opcodeIsIf(id)) {
+		info.flags |= OpcodeInfo::If;
+	}
+	if (id == OpcodeKey::RET || id == OpcodeKey::LABEL) {
+		info.flags |= OpcodeInfo::Void;
+	}
+	if (opcodeHasVariables(id)) {
+		info.flags |= OpcodeInfo::Variables;
+	}
+
+	return info;
+}
+
+static_assert(OpcodeKey::LABEL == 256, "Opcode::infos size mismatch");
+
+// Constant-initialized, the table is generated at compile time
+const OpcodeInfo Opcode::infos[257] = {
+#define op_fun(name) \
+	opcodeInfo(OpcodeKey::name, sizeof(Opcode##name)),
+#define op_sep
+	OPCODE_GENERATE_LIST
+#undef op_fun
+#undef op_sep
+};
+
 const quint8 Opcode::length[257] =
 {
     /* 00  RET      */    1,
@@ -1530,6 +1530,28 @@ STRUCTPACK(struct OpcodeLABEL : public OpcodeBase {
 	quint16 _label;
 });
 
+// Properties which only depend on the opcode id, see Opcode::info()
+struct OpcodeInfo {
+	enum Flag : quint8 {
+		Exec = 0x01,
+		Jump = 0x02,
+		LongJump = 0x04,
+		BackJump = 0x08,
+		If = 0x10,
+		Void = 0x20,
+		// The opcode can have var operands, see Opcode::variables()
+		Variables = 0x40
+	};
+
+	constexpr inline bool testFlag(Flag flag) const {
+		return (flags & flag) != 0;
+	}
+
+	// Size of the structure in the Opcode union, without resizable data
+	quint16 structSize = 0;
+	quint8 flags = 0;
+};
+
 class Opcode
 {
 public:
@@ -1618,12 +1640,33 @@ public:
 	// Unserializable byte array (include OpcodeLABEL case)
 	QByteArray serialize() const;
 	static Opcode unserialize(const QByteArray &data);
-	bool isExec() const;
-	bool isJump() const;
-	bool isLongJump() const;
-	bool isBackJump() const;
-	bool isIf() const;
-	bool isVoid() const;
+	// Compact form of serialize(), without the unused part of the union
+	void pack(QByteArray &data) const;
+	void unpack(const char *data, qsizetype size);
+	inline static OpcodeInfo info(OpcodeKey id) {
+		return id <= OpcodeKey::LABEL ? infos[id] : OpcodeInfo();
+	}
+	inline OpcodeInfo info() const {
+		return info(id());
+	}
+	inline bool isExec() const {
+		return info().testFlag(OpcodeInfo::Exec);
+	}
+	inline bool isJump() const {
+		return info().testFlag(OpcodeInfo::Jump);
+	}
+	inline bool isLongJump() const {
+		return info().testFlag(OpcodeInfo::LongJump);
+	}
+	inline bool isBackJump() const {
+		return info().testFlag(OpcodeInfo::BackJump);
+	}
+	inline bool isIf() const {
+		return info().testFlag(OpcodeInfo::If);
+	}
+	inline bool isVoid() const {
+		return info().testFlag(OpcodeInfo::Void);
+	}
 
 	bool searchVar(quint8 bank, quint16 address, Operation operation = None, int value = 65536) const;
 
@@ -1694,8 +1737,10 @@ public:
 	static const char *operators[OPERATORS_SIZE];
 	static const quint8 length[257];
 	static const char *names[257];
+	static const OpcodeInfo infos[257];
 private:
 	quint8 fixedSize() const;
+	size_t structSize() const;
 	void clearResizableDataPointers();
 	void deleteResizableData();
 	quint8 jumpShift() const;
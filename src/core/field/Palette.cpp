@@ -22,13 +22,26 @@
 
 Palette::Palette()
 {
+	_colorTable.fill(0);
+	_maskTable.fill(0);
 }
 
 Palette::Palette(const char *data)
 {
+	_colorTable.fill(0);
+	_maskTable.fill(0);
 	fromData(data);
 }
 
+Palette::Palette(const Palette &other) :
+    _colors(other._colors), _masks(other._masks), _isZero(other._isZero)
+{
+	_colorTable.fill(0);
+	_maskTable.fill(0);
+	// other can be a PalettePC
+	updateTables();
+}
+
 Palette::~Palette()
 {
 }
@@ -44,6 +57,18 @@ void Palette::fromData(const char *data)
 
 		data += 2;
 	}
+
+	updateTables();
+}
+
+void Palette::updateTables()
+{
+	const int count = qMin(size(), 256);
+
+	for (int i = 0; i < count; ++i) {
+		_colorTable[size_t(i)] = color(i);
+		_maskTable[size_t(i)] = notZero(quint8(i)) ? 0xFFFFFFFF : 0;
+	}
 }
 
 QByteArray Palette::toByteArray() const
@@ -91,14 +116,23 @@ PalettePC::PalettePC() :
 {
 }
 
+PalettePC::PalettePC(const PalettePC &other) :
+	Palette(other), _transparency(other._transparency)
+{
+	updateTables();
+}
+
 PalettePC::PalettePC(const Palette &palette, bool transparency) :
 	Palette(palette), _transparency(transparency)
 {
+	// The tables of the base class were built without PC rules
+	updateTables();
 }
 
 PalettePC::PalettePC(const char *data, bool transparency) :
 	Palette(data), _transparency(transparency)
 {
+	updateTables();
 }
 
 QRgb PalettePC::color(int index) const
@@ -122,6 +156,7 @@ bool PalettePC::transparency() const
 void PalettePC::setTransparency(bool transparency)
 {
 	_transparency = transparency;
+	updateTables();
 }
 
 QImage Palettes::toImage() const
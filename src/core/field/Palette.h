@@ -20,20 +20,34 @@
 #include <QtCore>
 #include <QRgb>
 #include <QImage>
+#include <array>
 
 class Palette
 {
 public:
 	Palette();
 	explicit Palette(const char *data);
+	Palette(const Palette &other);
 	virtual ~Palette();
+	Palette &operator=(const Palette &other) = default;
 	inline bool notZero(quint8 index) const { return !isZero(index); }
 	virtual inline bool isZero(int index) const {
 		return _isZero.at(index);
 	}
 	virtual inline QRgb color(int index) const { return _colors.at(index); }
 	inline bool mask(int index) const { return _masks.at(index); }
-	inline void setColor(int index, QRgb color) { _colors.replace(index, color); }
+	inline void setColor(int index, QRgb color) {
+		_colors.replace(index, color);
+		updateTables();
+	}
+	// color() and notZero() of the 256 indexes, as used to draw a pixel,
+	// the mask is 0xFFFFFFFF when the index is not transparent
+	inline const QRgb *colorTable() const {
+		return _colorTable.data();
+	}
+	inline const quint32 *maskTable() const {
+		return _maskTable.data();
+	}
 	inline const QList<bool> &areZero() const {
 		return _isZero;
 	}
@@ -47,6 +61,9 @@ public:
 	QByteArray toByteArray() const;
 	QImage toImage() const;
 	QImage toHorizontalImage() const;
+protected:
+	// To call after every modification of the colors or the transparency
+	void updateTables();
 private:
 	inline void addColor(QRgb color, bool mask, bool isZero) {
 		_colors.append(color);
@@ -57,13 +74,17 @@ private:
 	QList<QRgb> _colors;
 	QList<bool> _masks;
 	QList<bool> _isZero;
+	std::array<QRgb, 256> _colorTable;
+	std::array<quint32, 256> _maskTable;
 };
 
 class PalettePC : public Palette
 {
 public:
 	PalettePC();
+	PalettePC(const PalettePC &other);
 	PalettePC(const Palette &palette, bool transparency = false);
+	PalettePC &operator=(const PalettePC &other) = default;
 	explicit PalettePC(const char *data, bool transparency = false);
 	QRgb color(int index) const override;
 	bool isZero(int index) const override;
@@ -35,57 +35,141 @@ Script::Script(const char *script, qsizetype size)
 
 bool Script::openScript(const char *script, qsizetype scriptSize)
 {
-	qsizetype pos = 0, opcodeID = 0;
-	QList<qsizetype> positions;
-	QMultiMap<qsizetype, qsizetype> labelPositions;
+	qsizetype pos = 0;
+	QList<Opcode> opcodes;
+	QList<qsizetype> positions, jumps;
+	// Opcode starts, including the end of the script
+	QBitArray isOpcodeStart(scriptSize + 1);
 
-	// Collect label positions
+	// Collect opcode and label positions
 	while (pos < scriptSize) {
 		Opcode op(script + pos, scriptSize - pos);
-		_opcodes.append(op);
+		opcodes.append(op);
 		positions.append(pos);
+		isOpcodeStart.setBit(pos);
 		if (op.isJump()) {
-			labelPositions.insert(pos + op.jump(), opcodeID);
+			jumps.append(pos + op.jump());
 		}
 		pos += op.size();
-		++opcodeID;
 	}
 	positions.append(pos);
+	// The last opcode can overflow the script
+	isOpcodeStart.resize(pos + 1);
+	isOpcodeStart.setBit(pos);
+
+	// Labels are numbered by position
+	std::sort(jumps.begin(), jumps.end());
+	jumps.erase(std::unique(jumps.begin(), jumps.end()), jumps.end());
 
-	QList<qsizetype> labelPositionsKeys = labelPositions.uniqueKeys();
-
-	// Rely labels to jump opcodes
-	quint16 labelNumber = 1;
-	for (qsizetype jump: labelPositionsKeys) {
-		qsizetype index = positions.indexOf(jump);
-		const auto IDS = labelPositions.values(jump);
-		for (qsizetype opcodeID : IDS) {
-			_opcodes[opcodeID].setLabel(labelNumber);
-			_opcodes[opcodeID].setBadJump(
-			            index < 0
+	// Rely labels to jump opcodes and insert labels, in one pass
+	qsizetype opcodeCount = opcodes.size(), labelID = 0, labelCount = jumps.size();
+	_opcodes.reserve(opcodeCount + labelCount);
+
+	for (qsizetype opcodeID = 0; opcodeID <= opcodeCount; ++opcodeID) {
+		const qsizetype position = positions.at(opcodeID);
+
+		while (labelID < labelCount && jumps.at(labelID) < position) {
+			++labelID; // Invalid jump
+		}
+
+		if (labelID < labelCount && jumps.at(labelID) == position) {
+			OpcodeLABEL label;
+			label._label = quint16(labelID + 1);
+			_opcodes.append(label);
+		}
+
+		if (opcodeID == opcodeCount) {
+			break;
+		}
+
+		Opcode &op = opcodes[opcodeID];
+
+		if (op.isJump()) {
+			qsizetype jump = position + op.jump();
+			op.setLabel(quint16(std::lower_bound(jumps.cbegin(), jumps.cend(), jump) - jumps.cbegin() + 1));
+			op.setBadJump(
+			            jump < 0 || jump >= isOpcodeStart.size() || !isOpcodeStart.testBit(jump)
 			            ? (jump < 0
 			               ? BadJumpError::BeforeScript
 			               : (jump > 65535 ? BadJumpError::AfterScript : BadJumpError::InsideInstruction))
 			            : BadJumpError::Ok);
-			if (_opcodes[opcodeID].badJump() != BadJumpError::Ok) {
-				qWarning() << "Script::openScript" << "bad jump" << _opcodes[opcodeID].badJump();
+			if (op.badJump() != BadJumpError::Ok) {
+				qWarning() << "Script::openScript" << "bad jump" << op.badJump();
 			}
 		}
-		labelNumber += 1;
+
+		_opcodes.append(op);
 	}
 
-	// Insert labels
-	for (qsizetype i = labelPositionsKeys.size() - 1; i >= 0; --i) {
-		qsizetype jump = labelPositionsKeys.at(i);
-		qsizetype index = positions.indexOf(jump);
-		if (index > -1) {
-			OpcodeLABEL label;
-			label._label = quint16(i) + 1;
-			_opcodes.insert(index, label);
+	return true;
+}
+
+void Script::pack()
+{
+	if (_opcodes.isEmpty()) {
+		return;
+	}
+
+	_packedOpcodes.clear();
+	_packedPositions.clear();
+	_packedPositions.reserve(_opcodes.size());
+
+	for (const Opcode &opcode : qAsConst(_opcodes)) {
+		_packedPositions.append(quint32(_packedOpcodes.size()));
+		opcode.pack(_packedOpcodes);
+	}
+
+	_packedOpcodes.squeeze();
+	_opcodes = QList<Opcode>();
+}
+
+void Script::unpack() const
+{
+	if (_packedPositions.isEmpty()) {
+		return;
+	}
+
+	qsizetype count = _packedPositions.size();
+	QList<Opcode> opcodes(count);
+
+	for (qsizetype i = 0; i < count; ++i) {
+		opcodeAt(i, opcodes[i]);
+	}
+
+	_opcodes = opcodes;
+	_packedOpcodes = QByteArray();
+	_packedPositions = QList<quint32>();
+}
+
+const Opcode &Script::opcodeAt(qsizetype opcodeID, Opcode &decoded) const
+{
+	if (_packedPositions.isEmpty()) {
+		return _opcodes.at(opcodeID);
+	}
+
+	qsizetype pos = _packedPositions.at(opcodeID),
+	        end = opcodeID + 1 < _packedPositions.size()
+	              ? _packedPositions.at(opcodeID + 1)
+	              : _packedOpcodes.size();
+	decoded.unpack(_packedOpcodes.constData() + pos, end - pos);
+
+	return decoded;
+}
+
+qsizetype Script::memoryUsage() const
+{
+	qsizetype ret = _packedOpcodes.capacity()
+	        + _packedPositions.capacity() * qsizetype(sizeof(quint32))
+	        + _opcodes.capacity() * qsizetype(sizeof(Opcode));
+
+	for (const Opcode &opcode : qAsConst(_opcodes)) {
+		QByteArray data = opcode.resizableData();
+		if (!data.isNull()) {
+			ret += qsizetype(sizeof(QByteArray)) + data.capacity();
 		}
 	}
 
-	return true;
+	return ret;
 }
 
 Script Script::splitScriptAtReturn()
@@ -93,6 +177,8 @@ Script Script::splitScriptAtReturn()
 	int gotoLabel = -1;
 	int opcodeID = 0;
 
+	unpack();
+
 	for (const Opcode &opcode : qAsConst(_opcodes)) {
 		if (opcode.id() == OpcodeKey::LABEL) {
 			if (gotoLabel != -1 && opcode.op().opcodeLABEL._label == quint32(gotoLabel)) {
@@ -120,12 +206,12 @@ Script Script::splitScriptAtReturn()
 
 qsizetype Script::size() const
 {
-	return _opcodes.size();
+	return isPacked() ? _packedPositions.size() : _opcodes.size();
 }
 
 bool Script::isEmpty() const
 {
-	return _opcodes.isEmpty();
+	return size() == 0;
 }
 
 bool Script::isValid() const
@@ -135,21 +221,25 @@ bool Script::isValid() const
 
 Opcode &Script::opcode(qsizetype opcodeID)
 {
+	unpack();
 	return _opcodes[opcodeID];
 }
 
 const Opcode &Script::opcode(qsizetype opcodeID) const
 {
+	unpack();
 	return _opcodes.at(opcodeID);
 }
 
 QList<Opcode> &Script::opcodes()
 {
+	unpack();
 	return _opcodes;
 }
 
 const QList<Opcode> &Script::opcodes() const
 {
+	unpack();
 	return _opcodes;
 }
 
@@ -158,6 +248,8 @@ bool Script::compile(int &opcodeID, QString &errorStr)
 	qint32 pos = 0;
 	QHash<quint16, qint32> labelPositions; // Each label is unique
 
+	unpack();
+
 	// Search labels
 	opcodeID = 0;
 	for (const Opcode &opcode : qAsConst(_opcodes)) {
@@ -264,9 +356,11 @@ bool Script::compile(int &opcodeID, QString &errorStr)
 QByteArray Script::toByteArray() const
 {
 	QByteArray ret;
+	Opcode decoded;
+	qsizetype count = size();
 
-	for (const Opcode &opcode : _opcodes) {
-		ret.append(opcode.toByteArray());
+	for (qsizetype i = 0; i < count; ++i) {
+		ret.append(opcodeAt(i, decoded).toByteArray());
 	}
 
 	return ret;
@@ -274,8 +368,11 @@ QByteArray Script::toByteArray() const
 
 bool Script::isVoid() const
 {
-	for (const Opcode &opcode : _opcodes) {
-		if (!opcode.isVoid()) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		if (!opcodeAt(i, decoded).isVoid()) {
 			return false;
 		}
 	}
@@ -284,21 +381,26 @@ bool Script::isVoid() const
 
 void Script::setOpcode(qsizetype opcodeID, const Opcode &opcode)
 {
+	unpack();
 	_opcodes.replace(opcodeID, opcode);
 }
 
 void Script::removeOpcode(qsizetype opcodeID)
 {
+	unpack();
 	_opcodes.removeAt(opcodeID);
 }
 
 void Script::insertOpcode(qsizetype opcodeID, const Opcode &opcode)
 {
+	unpack();
 	_opcodes.insert(opcodeID, opcode);
 }
 
 bool Script::moveOpcode(qsizetype opcodeID, MoveDirection direction)
 {
+	unpack();
+
 	if (opcodeID >= _opcodes.size()) {
 		return false;
 	}
@@ -323,11 +425,12 @@ bool Script::searchOpcode(int opcode, int &opcodeID) const
 		opcodeID = 0;
 	}
 
-	if (opcodeID >= _opcodes.size()) {
+	if (opcodeID >= size()) {
 		return false;
 	}
 
-	if ((opcode & 0xFFFF) == _opcodes.at(opcodeID).id()) {
+	Opcode decoded;
+	if ((opcode & 0xFFFF) == opcodeAt(opcodeID, decoded).id()) {
 		return true;
 	}
 
@@ -340,11 +443,12 @@ bool Script::searchVar(quint8 bank, quint16 address, Opcode::Operation op, int v
 		opcodeID = 0;
 	}
 
-	if (opcodeID >= _opcodes.size()) {
+	if (opcodeID >= size()) {
 		return false;
 	}
 
-	if (_opcodes.at(opcodeID).searchVar(bank, address, op, value)) {
+	Opcode decoded;
+	if (opcodeAt(opcodeID, decoded).searchVar(bank, address, op, value)) {
 		return true;
 	}
 
@@ -353,7 +457,11 @@ bool Script::searchVar(quint8 bank, quint16 address, Opcode::Operation op, int v
 
 void Script::searchAllVars(QList<FF7Var> &vars) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		opcode.variables(vars);
 	}
 }
@@ -364,11 +472,12 @@ bool Script::searchExec(quint8 group, quint8 script, int &opcodeID) const
 		opcodeID = 0;
 	}
 
-	if (opcodeID >= _opcodes.size()) {
+	if (opcodeID >= size()) {
 		return false;
 	}
 
-	const Opcode &op = _opcodes.at(opcodeID);
+	Opcode decoded;
+	const Opcode &op = opcodeAt(opcodeID, decoded);
 
 	if (op.groupID() == group && op.scriptID() == script) {
 		return true;
@@ -383,11 +492,12 @@ bool Script::searchMapJump(quint16 map, int &opcodeID) const
 		opcodeID = 0;
 	}
 
-	if (opcodeID >= _opcodes.size()) {
+	if (opcodeID >= size()) {
 		return false;
 	}
 
-	if (_opcodes.at(opcodeID).mapID() == map) {
+	Opcode decoded;
+	if (opcodeAt(opcodeID, decoded).mapID() == map) {
 		return true;
 	}
 
@@ -400,11 +510,12 @@ bool Script::searchTextInScripts(const QRegularExpression &text, int &opcodeID,
 		opcodeID = 0;
 	}
 
-	if (opcodeID >= _opcodes.size()) {
+	if (opcodeID >= size()) {
 		return false;
 	}
 
-	qint16 textID = _opcodes.at(opcodeID).textID();
+	Opcode decoded;
+	qint16 textID = opcodeAt(opcodeID, decoded).textID();
 
 	if (textID >= 0 && textID < scriptsAndTexts->textCount() && scriptsAndTexts->text(textID).contains(text)) {
 		return true;
@@ -415,15 +526,16 @@ bool Script::searchTextInScripts(const QRegularExpression &text, int &opcodeID,
 
 bool Script::searchOpcodeP(int opcode, int &opcodeID) const
 {
-	if (opcodeID >= _opcodes.size()) {
-		opcodeID = _opcodes.size() - 1;
+	if (opcodeID >= size()) {
+		opcodeID = size() - 1;
 	}
 
 	if (opcodeID < 0) {
 		return false;
 	}
 
-	if ((opcode & 0xFFFF) == _opcodes.at(opcodeID).id()) {
+	Opcode decoded;
+	if ((opcode & 0xFFFF) == opcodeAt(opcodeID, decoded).id()) {
 		return true;
 	}
 
@@ -432,15 +544,16 @@ bool Script::searchOpcodeP(int opcode, int &opcodeID) const
 
 bool Script::searchVarP(quint8 bank, quint16 address, Opcode::Operation op, int value, int &opcodeID) const
 {
-	if (opcodeID >= _opcodes.size()) {
-		opcodeID = _opcodes.size() - 1;
+	if (opcodeID >= size()) {
+		opcodeID = size() - 1;
 	}
 
 	if (opcodeID < 0) {
 		return false;
 	}
 
-	if (_opcodes.at(opcodeID).searchVar(bank, address, op, value)) {
+	Opcode decoded;
+	if (opcodeAt(opcodeID, decoded).searchVar(bank, address, op, value)) {
 		return true;
 	}
 
@@ -449,15 +562,16 @@ bool Script::searchVarP(quint8 bank, quint16 address, Opcode::Operation op, int
 
 bool Script::searchExecP(quint8 group, quint8 script, int &opcodeID) const
 {
-	if (opcodeID >= _opcodes.size()) {
-		opcodeID = _opcodes.size() - 1;
+	if (opcodeID >= size()) {
+		opcodeID = size() - 1;
 	}
 
 	if (opcodeID < 0) {
 		return false;
 	}
 
-	Opcode op = _opcodes.at(opcodeID);
+	Opcode decoded;
+	const Opcode &op = opcodeAt(opcodeID, decoded);
 	if (op.groupID() == group && op.scriptID() == script) {
 		return true;
 	}
@@ -467,15 +581,16 @@ bool Script::searchExecP(quint8 group, quint8 script, int &opcodeID) const
 
 bool Script::searchMapJumpP(quint16 map, int &opcodeID) const
 {
-	if (opcodeID >= _opcodes.size()) {
-		opcodeID = _opcodes.size() - 1;
+	if (opcodeID >= size()) {
+		opcodeID = size() - 1;
 	}
 
 	if (opcodeID < 0) {
 		return false;
 	}
 
-	if (_opcodes.at(opcodeID).mapID() == map) {
+	Opcode decoded;
+	if (opcodeAt(opcodeID, decoded).mapID() == map) {
 		return true;
 	}
 
@@ -484,15 +599,16 @@ bool Script::searchMapJumpP(quint16 map, int &opcodeID) const
 
 bool Script::searchTextInScriptsP(const QRegularExpression &text, int &opcodeID, const Section1File *scriptsAndTexts) const
 {
-	if (opcodeID >= _opcodes.size()) {
-		opcodeID = _opcodes.size() - 1;
+	if (opcodeID >= size()) {
+		opcodeID = size() - 1;
 	}
 
 	if (opcodeID < 0) {
 		return false;
 	}
 	
-	qint16 textID = _opcodes.at(opcodeID).textID();
+	Opcode decoded;
+	qint16 textID = opcodeAt(opcodeID, decoded).textID();
 
 	if (textID >= 0 && textID < scriptsAndTexts->textCount() && scriptsAndTexts->text(textID).contains(text)) {
 		return true;
@@ -503,7 +619,11 @@ bool Script::searchTextInScriptsP(const QRegularExpression &text, int &opcodeID,
 
 void Script::listUsedTexts(QSet<quint8> &usedTexts) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		qint16 textID = opcode.textID();
 		if (textID >= 0) {
 			usedTexts.insert(quint8(textID));
@@ -513,7 +633,11 @@ void Script::listUsedTexts(QSet<quint8> &usedTexts) const
 
 void Script::listUsedTuts(QSet<quint8> &usedTuts) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		qint16 tutoID = opcode.tutoID();
 		if (tutoID >= 0) {
 			usedTuts.insert(quint8(tutoID));
@@ -523,6 +647,8 @@ void Script::listUsedTuts(QSet<quint8> &usedTuts) const
 
 void Script::shiftGroupIds(quint8 groupId, qint16 steps)
 {
+	unpack();
+
 	for (Opcode &opcode : _opcodes) {
 		qint16 groupID = opcode.groupID();
 		if (groupID >= 0 && groupID > groupId) {
@@ -533,6 +659,8 @@ void Script::shiftGroupIds(quint8 groupId, qint16 steps)
 
 void Script::shiftTextIds(quint8 textId, qint16 steps)
 {
+	unpack();
+
 	for (Opcode &opcode : _opcodes) {
 		qint16 textID = opcode.textID();
 		if (textID >= 0 && textID > textId) {
@@ -543,6 +671,8 @@ void Script::shiftTextIds(quint8 textId, qint16 steps)
 
 void Script::shiftTutIds(quint8 tutoId, qint16 steps)
 {
+	unpack();
+
 	for (Opcode &opcode : _opcodes) {
 		qint16 tutoID = opcode.tutoID();
 		if (tutoID >= 0 && tutoID > tutoId) {
@@ -553,6 +683,8 @@ void Script::shiftTutIds(quint8 tutoId, qint16 steps)
 
 void Script::shiftPalIds(quint8 palId, qint16 steps)
 {
+	unpack();
+
 	for (Opcode &opcode : _opcodes) {
 		qint16 paletteID = opcode.paletteID();
 		if (paletteID >= 0 && paletteID > palId) {
@@ -563,6 +695,8 @@ void Script::shiftPalIds(quint8 palId, qint16 steps)
 
 void Script::swapGroupIds(quint8 groupId1, quint8 groupId2)
 {
+	unpack();
+
 	for (Opcode &opcode : _opcodes) {
 		qint16 groupID = opcode.groupID();
 		if (groupID == groupId1) {
@@ -575,6 +709,8 @@ void Script::swapGroupIds(quint8 groupId1, quint8 groupId2)
 
 void Script::setWindow(const FF7Window &win)
 {
+	unpack();
+
 	if (win.opcodeID < _opcodes.size()) {
 		_opcodes[win.opcodeID].setWindow(win);
 	}
@@ -583,13 +719,10 @@ void Script::setWindow(const FF7Window &win)
 quint32 Script::opcodePositionInBytes(qsizetype opcodeID) const
 {
 	quint32 pos = 0;
-	qsizetype i = 0;
-	for (const Opcode &op : _opcodes) {
-		if (i == opcodeID) {
-			return pos;
-		}
-		pos += op.size();
-		++i;
+	qsizetype count = qMin(opcodeID, size());
+	Opcode decoded;
+	for (qsizetype i = 0; i < count; ++i) {
+		pos += opcodeAt(i, decoded).size();
 	}
 	return pos;
 }
@@ -597,7 +730,11 @@ quint32 Script::opcodePositionInBytes(qsizetype opcodeID) const
 void Script::listWindows(int groupID, int scriptID, QMultiMap<quint64, FF7Window> &windows, QMultiMap<quint8, quint64> &text2win) const
 {
 	int opcodeID = 0;
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		qint16 windowID = opcode.windowID();
 		if (windowID >= 0 || opcode.id() == OpcodeKey::MPNAM) {
 			FF7Window win = FF7Window();
@@ -628,7 +765,11 @@ void Script::listWindows(int groupID, int scriptID, int textID, QList<FF7Window>
 {
 	int opcodeID = 0;
 	QMap<int, FF7Window> lastWinPerWindowID;
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		if (opcode.isJump() || (opcode.id() <= OpcodeKey::RETTO
 		                         && opcode.id() != OpcodeKey::REQ
 		                         && opcode.id() != OpcodeKey::PREQ)) {
@@ -693,7 +834,11 @@ void Script::listWindows(int groupID, int scriptID, int textID, QList<FF7Window>
 
 void Script::listModelPositions(QList<FF7Position> &positions) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		FF7Position pos;
 		if (opcode.modelPosition(pos)) {
 			positions.append(pos);
@@ -703,7 +848,11 @@ void Script::listModelPositions(QList<FF7Position> &positions) const
 
 bool Script::linePosition(FF7Position position[2]) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		if (opcode.linePosition(position)) {
 			return true;
 		}
@@ -713,7 +862,11 @@ bool Script::linePosition(FF7Position position[2]) const
 
 void Script::backgroundParams(QHash<quint8, quint8> &enabledParams) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		if (opcode.id() == OpcodeKey::BGON) { // Show background parameter
 			const OpcodeBGON &bgon = opcode.op().opcodeBGON;
 			if (bgon.banks == 0) {
@@ -740,7 +893,11 @@ void Script::backgroundParams(QHash<quint8, quint8> &enabledParams) const
 
 void Script::backgroundMove(qint16 z[2], qint16 *x, qint16 *y) const
 {
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		if (opcode.id() == OpcodeKey::BGPDH) { // Move Background Z
 			const OpcodeBGPDH &bgpdh = opcode.op().opcodeBGPDH;
 			if (bgpdh.banks == 0 && bgpdh.layerID > 1 && bgpdh.layerID < 4) { // No var
@@ -760,6 +917,9 @@ bool Script::removeTexts()
 {
 	bool modified = false;
 	qsizetype i = 0;
+
+	unpack();
+
 	for (const Opcode &opcode : qAsConst(_opcodes)) {
 		if (opcode.id() != OpcodeKey::ASK
 				&& opcode.id() != OpcodeKey::MPNAM
@@ -777,7 +937,11 @@ QString Script::toString(const Section1File *scriptsAndTexts) const
 {
 	QString ret;
 
-	for (const Opcode &opcode : _opcodes) {
+	Opcode decoded;
+	qsizetype count = size();
+
+	for (qsizetype i = 0; i < count; ++i) {
+		const Opcode &opcode = opcodeAt(i, decoded);
 		ret.append(opcode.toString(scriptsAndTexts));
 		ret.append("\n");
 	}
@@ -32,6 +32,18 @@ public:
 	Script(const char *script, qsizetype size);
 
 	bool openScript(const char *script, qsizetype size);
+	// Stores the opcodes in a byte stream, they are decoded again on the
+	// first modification or reference access. Read-only methods decode
+	// the opcodes one by one and keep the script packed
+	void pack();
+	inline bool isPacked() const {
+		return !_packedPositions.isEmpty();
+	}
+	// Approximate heap size of the opcodes, in bytes
+	qsizetype memoryUsage() const;
+	// Read-only access which keeps the script packed,
+	// the returned reference can point to decoded
+	const Opcode &opcodeAt(qsizetype opcodeID, Opcode &decoded) const;
 	qsizetype size() const;
 	bool isEmpty() const;
 	bool isValid() const;
@@ -82,7 +94,11 @@ public:
 
 	QString toString(const Section1File *scriptsAndTexts) const;
 private:
-	QList<Opcode> _opcodes;
+	void unpack() const;
+
+	mutable QList<Opcode> _opcodes;
+	mutable QByteArray _packedOpcodes;
+	mutable QList<quint32> _packedPositions;
 	QString lastError;
 
 	bool valid;
@@ -0,0 +1,310 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "ScriptIndex.h"
+#include "Section1File.h"
+
+#define SCRIPT_INDEX_MAGIC    0x4D4B5349 // MKSI
+#define SCRIPT_INDEX_VERSION  1
+
+ScriptIndex::ScriptIndex() :
+	_modified(false)
+{
+}
+
+void ScriptIndex::clear()
+{
+	QMutexLocker locker(&_mutex);
+	_fields.clear();
+	_modified = false;
+}
+
+bool ScriptIndex::isEmpty() const
+{
+	QMutexLocker locker(&_mutex);
+	return _fields.isEmpty();
+}
+
+bool ScriptIndex::contains(int mapID) const
+{
+	QMutexLocker locker(&_mutex);
+	return _fields.contains(mapID);
+}
+
+bool ScriptIndex::isModified() const
+{
+	QMutexLocker locker(&_mutex);
+	return _modified;
+}
+
+void ScriptIndex::addField(int mapID, const Section1File *scripts, bool persistent)
+{
+	FieldEntry entry;
+	entry.persistent = persistent;
+
+	auto add = [&entry](quint32 key, const Location &location) {
+		QList<Location> &locations = entry.postings[key];
+		// Several variables of the same opcode can give the same key
+		if (locations.isEmpty() || locations.last().opcodeID != location.opcodeID
+		        || locations.last().scriptID != location.scriptID
+		        || locations.last().groupID != location.groupID) {
+			locations.append(location);
+		}
+	};
+
+	Location location;
+	location.groupID = 0;
+	QList<FF7Var> vars;
+
+	for (const GrpScript &grpScript : scripts->grpScripts()) {
+		location.scriptID = 0;
+		for (const Script &script : grpScript.scripts()) {
+			Opcode decoded;
+			qsizetype count = script.size();
+			location.opcodeID = 0;
+			for (qsizetype opcodeID = 0; opcodeID < count; ++opcodeID) {
+				const Opcode &opcode = script.opcodeAt(opcodeID, decoded);
+				add(opcodeKey(opcode.id()), location);
+
+				vars.clear();
+				opcode.variables(vars);
+				for (const FF7Var &var : qAsConst(vars)) {
+					add(varKey(var.bank, var.address), location);
+					add(key(VarBankKey, var.bank), location);
+				}
+
+				FF7If i;
+				if (opcode.ifStruct(i) && i.bank1 != 0) {
+					add(varKey(i.bank1, quint16(i.value1 & 0xFF)), location);
+					add(key(VarBankKey, i.bank1), location);
+				}
+
+				if (opcode.groupID() >= 0 && opcode.scriptID() >= 0) {
+					add(execKey(quint8(opcode.groupID()), quint8(opcode.scriptID())), location);
+				}
+
+				if (opcode.mapID() >= 0) {
+					add(mapJumpKey(quint16(opcode.mapID())), location);
+				}
+
+				++location.opcodeID;
+			}
+			++location.scriptID;
+		}
+		++location.groupID;
+	}
+
+	QMutexLocker locker(&_mutex);
+	_fields.insert(mapID, entry);
+	if (persistent) {
+		_modified = true;
+	}
+}
+
+void ScriptIndex::removeField(int mapID)
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _fields.constFind(mapID);
+	if (it != _fields.constEnd()) {
+		if (it->persistent) {
+			_modified = true;
+		}
+		_fields.erase(it);
+	}
+}
+
+void ScriptIndex::setSaved()
+{
+	QMutexLocker locker(&_mutex);
+	for (FieldEntry &entry : _fields) {
+		if (!entry.persistent) {
+			entry.persistent = true;
+			_modified = true;
+		}
+	}
+}
+
+bool ScriptIndex::fieldContains(int mapID, quint32 key) const
+{
+	QMutexLocker locker(&_mutex);
+	auto it = _fields.constFind(mapID);
+	return it != _fields.constEnd() && it->postings.contains(key);
+}
+
+QList<ScriptIndexPosting> ScriptIndex::postings(quint32 key) const
+{
+	QList<ScriptIndexPosting> ret;
+	ScriptIndexPosting posting;
+	QMutexLocker locker(&_mutex);
+
+	for (auto it = _fields.constBegin(); it != _fields.constEnd(); ++it) {
+		auto locationsIt = it->postings.constFind(key);
+		if (locationsIt == it->postings.constEnd()) {
+			continue;
+		}
+		posting.mapID = it.key();
+		for (const Location &location : *locationsIt) {
+			posting.groupID = location.groupID;
+			posting.scriptID = location.scriptID;
+			posting.opcodeID = location.opcodeID;
+			ret.append(posting);
+		}
+	}
+
+	return ret;
+}
+
+QString ScriptIndex::indexFilePath(const QString &archivePath)
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	if (dir.isEmpty()) {
+		return QString();
+	}
+
+	QByteArray hash = QCryptographicHash::hash(QDir::cleanPath(archivePath).toUtf8(),
+	                                           QCryptographicHash::Sha1);
+
+	return dir + "/scriptIndex/" + QString::fromLatin1(hash.toHex()) + ".idx";
+}
+
+bool ScriptIndex::archiveStamp(const QString &archivePath, qint64 &size, qint64 &lastModified)
+{
+	QFileInfo info(archivePath);
+	// The modification date of a directory does not change
+	// when a file inside is rewritten: not persisted
+	if (!info.exists() || info.isDir() || !info.lastModified().isValid()) {
+		return false;
+	}
+	size = info.size();
+	lastModified = info.lastModified().toMSecsSinceEpoch();
+	return true;
+}
+
+bool ScriptIndex::load(const QString &archivePath)
+{
+	QMutexLocker locker(&_mutex);
+	_fields.clear();
+	_modified = false;
+
+	qint64 size, lastModified;
+	QString path = indexFilePath(archivePath);
+	if (path.isEmpty() || !archiveStamp(archivePath, size, lastModified)) {
+		return false;
+	}
+
+	QFile f(path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		return false;
+	}
+
+	QDataStream stream(&f);
+	stream.setVersion(QDataStream::Qt_6_0);
+	quint32 magic, fieldCount;
+	quint16 version;
+	QString storedPath;
+	qint64 storedSize, storedLastModified;
+
+	stream >> magic >> version >> storedPath >> storedSize >> storedLastModified >> fieldCount;
+
+	if (stream.status() != QDataStream::Ok || magic != SCRIPT_INDEX_MAGIC
+	        || version != SCRIPT_INDEX_VERSION
+	        || storedPath != QDir::cleanPath(archivePath)
+	        || storedSize != size || storedLastModified != lastModified) {
+		return false;
+	}
+
+	for (quint32 i = 0; i < fieldCount && stream.status() == QDataStream::Ok; ++i) {
+		qint32 mapID;
+		quint32 keyCount;
+		FieldEntry entry;
+		entry.persistent = true;
+
+		stream >> mapID >> keyCount;
+
+		for (quint32 j = 0; j < keyCount && stream.status() == QDataStream::Ok; ++j) {
+			quint32 key, locationCount;
+			stream >> key >> locationCount;
+
+			QList<Location> &locations = entry.postings[key];
+			for (quint32 k = 0; k < locationCount && stream.status() == QDataStream::Ok; ++k) {
+				Location location;
+				stream >> location.groupID >> location.scriptID >> location.opcodeID;
+				locations.append(location);
+			}
+		}
+
+		_fields.insert(mapID, entry);
+	}
+
+	if (stream.status() != QDataStream::Ok) {
+		_fields.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool ScriptIndex::save(const QString &archivePath)
+{
+	qint64 size, lastModified;
+	QString path = indexFilePath(archivePath);
+	if (path.isEmpty() || !archiveStamp(archivePath, size, lastModified)
+	        || !QDir().mkpath(QFileInfo(path).absolutePath())) {
+		return false;
+	}
+
+	QMutexLocker locker(&_mutex);
+
+	QSaveFile f(path);
+	if (!f.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+
+	quint32 fieldCount = 0;
+	for (const FieldEntry &entry : qAsConst(_fields)) {
+		if (entry.persistent) {
+			++fieldCount;
+		}
+	}
+
+	QDataStream stream(&f);
+	stream.setVersion(QDataStream::Qt_6_0);
+	stream << quint32(SCRIPT_INDEX_MAGIC) << quint16(SCRIPT_INDEX_VERSION)
+	       << QDir::cleanPath(archivePath) << size << lastModified << fieldCount;
+
+	for (auto it = _fields.constBegin(); it != _fields.constEnd(); ++it) {
+		if (!it->persistent) {
+			continue;
+		}
+
+		stream << qint32(it.key()) << quint32(it->postings.size());
+
+		for (auto keyIt = it->postings.constBegin(); keyIt != it->postings.constEnd(); ++keyIt) {
+			stream << keyIt.key() << quint32(keyIt->size());
+			for (const Location &location : *keyIt) {
+				stream << location.groupID << location.scriptID << location.opcodeID;
+			}
+		}
+	}
+
+	if (stream.status() != QDataStream::Ok || !f.commit()) {
+		return false;
+	}
+
+	_modified = false;
+	return true;
+}
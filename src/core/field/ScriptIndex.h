@@ -0,0 +1,100 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+
+class Section1File;
+
+struct ScriptIndexPosting
+{
+	int mapID;
+	int groupID, scriptID, opcodeID;
+};
+
+/*
+ * Inverted index of the field scripts: opcode ids, variables,
+ * exec targets and map jumps -> (mapID, groupID, scriptID, opcodeID).
+ * Fields are indexed one by one, a field missing from the index
+ * has to be searched the usual way.
+ * The index is stored on disk next to the other cache files,
+ * keyed by the archive path, size and modification date
+ * (directories are not persisted).
+ * The index is shared by the GUI and the Find All thread,
+ * every method locks it.
+ */
+class ScriptIndex
+{
+public:
+	enum KeyType : quint8 {
+		OpcodeKey = 1, VarKey, VarBankKey, ExecKey, MapJumpKey
+	};
+
+	static constexpr quint32 NoKey = 0;
+
+	inline static quint32 key(KeyType type, quint16 value) {
+		return (quint32(type) << 16) | value;
+	}
+	inline static quint32 opcodeKey(int opcode) {
+		return key(OpcodeKey, quint16(opcode & 0xFFFF));
+	}
+	// address > 0xFF means every address of the bank
+	inline static quint32 varKey(quint8 bank, quint16 address) {
+		return address > 0xFF ? key(VarBankKey, bank)
+		                      : key(VarKey, quint16((bank << 8) | address));
+	}
+	inline static quint32 execKey(quint8 group, quint8 script) {
+		return key(ExecKey, quint16((group << 8) | script));
+	}
+	inline static quint32 mapJumpKey(quint16 map) {
+		return key(MapJumpKey, map);
+	}
+
+	ScriptIndex();
+
+	void clear();
+	bool isEmpty() const;
+	bool contains(int mapID) const;
+	bool isModified() const;
+	// persistent = false when the scripts differ from the archive on disk
+	void addField(int mapID, const Section1File *scripts, bool persistent);
+	void removeField(int mapID);
+	void setSaved();
+
+	bool fieldContains(int mapID, quint32 key) const;
+	QList<ScriptIndexPosting> postings(quint32 key) const;
+
+	bool load(const QString &archivePath);
+	bool save(const QString &archivePath);
+private:
+	struct Location {
+		qint16 groupID, scriptID;
+		qint32 opcodeID;
+	};
+	struct FieldEntry {
+		QHash<quint32, QList<Location>> postings;
+		bool persistent;
+	};
+
+	static QString indexFilePath(const QString &archivePath);
+	static bool archiveStamp(const QString &archivePath, qint64 &size, qint64 &lastModified);
+
+	mutable QMutex _mutex;
+	QMap<int, FieldEntry> _fields;
+	bool _modified;
+};
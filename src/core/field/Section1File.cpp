@@ -114,10 +114,12 @@ void Section1File::initEmpty()
 
 bool Section1File::open()
 {
-	return open(field()->sectionData(Field::Scripts));
+	QByteArray buffer;
+
+	return open(field()->sectionView(Field::Scripts, buffer));
 }
 
-bool Section1File::open(const QByteArray &data)
+bool Section1File::open(QByteArrayView data)
 {
 	quint16 version, posTexts;
 	int cur;
@@ -236,24 +238,19 @@ bool Section1File::open(const QByteArray &data)
 				}
 			}
 
-			quint8 scriptID = 0;
-			for (quint8 j = 0; j < scriptCount; ++j) {
-				if (positions[j + 1] > positions[j]) {
-					Script script(constData + positions[j], positions[j + 1] - positions[j]);
-					if (!script.isValid()) {
-						qWarning() << "Section1File::open invalid script" << i << j;
-						return false;
-					}
-					if (scriptID == 0) {
-						Script scriptMain = script.splitScriptAtReturn();
-						grpScript.setScript(0, script); // S0 - Init
-						grpScript.setScript(1, scriptMain); // S0 - Main
-					} else {
-						grpScript.setScript(scriptID + 1, script);
-					}
-					scriptID = j + 1;
-				}
+			// Scripts are decoded by the group on first access
+			quint16 first = positions[0], last = positions[0];
+			for (quint8 j = 1; j <= scriptCount; ++j) {
+				first = qMin(first, positions[j]);
+				last = qMax(last, positions[j]);
 			}
+			last = quint16(qBound(qsizetype(first), qsizetype(last), dataSize));
+
+			QList<quint16> scriptsPositions(scriptCount + 1);
+			for (quint8 j = 0; j <= scriptCount; ++j) {
+				scriptsPositions[j] = positions[j] - first;
+			}
+			grpScript.setScriptsData(QByteArray(constData + first, last - first), scriptsPositions);
 		}
 		
 		_grpScripts.append(grpScript);
@@ -921,6 +918,12 @@ void Section1File::cleanTexts()
 
 void Section1File::autosizeTextWindows()
 {
+	autosizeTextWindows(FF7Font::sizeSettings());
+}
+
+void Section1File::autosizeTextWindows(const FF7Font::SizeSettings &settings)
+{
+	QList<int> pagesPos;
 	QSet<quint8> textIDs = listUsedTexts();
 	for (quint8 textID : textIDs) {
 		if (textID >= _texts.size()) {
@@ -929,7 +932,7 @@ void Section1File::autosizeTextWindows()
 		QList<FF7Window> windows;
 		listWindows(textID, windows);
 		if (!windows.isEmpty()) {
-			QSize size = FF7Font::calcSize(text(textID).data());
+			QSize size = FF7Font::calcSize(text(textID).data(), pagesPos, settings);
 			for (FF7Window win : qAsConst(windows)) {
 				if (win.displayType > 0) {
 					continue; // TODO: estimate size for countdown and numerical display
@@ -21,6 +21,7 @@
 #include "FieldPart.h"
 #include "GrpScript.h"
 #include "TutFileStandard.h"
+#include "core/FF7Font.h"
 
 #include <FF7String>
 
@@ -35,7 +36,7 @@ public:
 	void clear() override;
 	void initEmpty() override;
 	bool open() override;
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	QByteArray save() const override;
 	bool exporter(QIODevice *device, ExportFormat format);
 	bool importer(QIODevice *device, ExportFormat format);
@@ -79,6 +80,8 @@ public:
 	void removeTexts();
 	void cleanTexts();
 	void autosizeTextWindows();
+	// Thread safe version, settings from FF7Font::sizeSettings()
+	void autosizeTextWindows(const FF7Font::SizeSettings &settings);
 
 	const QList<FF7String> &texts() const;
 	qsizetype textCount() const;
@@ -31,7 +31,7 @@ TutFile::TutFile(const QList<QByteArray> &tutos) :
 	setOpen(true);
 }
 
-bool TutFile::open(const QByteArray &data)
+bool TutFile::open(QByteArrayView data)
 {
 	QList<quint32> positions;
 	qsizetype dataSize = data.size();
@@ -44,8 +44,8 @@ bool TutFile::open(const QByteArray &data)
 	tutos.clear();
 	for (int i=0; i<positions.size()-1; ++i) {
 		if (positions.at(i) < dataSize && positions.at(i) < positions.at(i+1)) {
-			tutos.append(data.mid(positions.at(i),
-			                      positions.at(i+1) - positions.at(i)));
+			tutos.append(data.sliced(positions.at(i),
+			                         qMin(qsizetype(positions.at(i+1)), dataSize) - positions.at(i)).toByteArray());
 		}
 	}
 
@@ -25,7 +25,7 @@ class TutFile : public FieldPart
 public:
 	explicit TutFile(Field *field = nullptr);
 	explicit TutFile(const QList<QByteArray> &tutos);
-	bool open(const QByteArray &data) override;
+	bool open(QByteArrayView data) override;
 	inline void clear() override {
 		tutos.clear();
 	}
@@ -63,7 +63,7 @@ public:
 	virtual bool parseText(int tutID, const QString &tuto);
 	static void testParsing();
 protected:
-	virtual QList<quint32> openPositions(const QByteArray &data) const=0;
+	virtual QList<quint32> openPositions(QByteArrayView data) const=0;
 	inline QByteArray &dataRef(int tutID) {
 		return tutos[tutID];
 	}
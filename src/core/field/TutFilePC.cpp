@@ -27,7 +27,7 @@ bool TutFilePC::open()
 	return false;
 }
 
-QList<quint32> TutFilePC::openPositions(const QByteArray &data) const
+QList<quint32> TutFilePC::openPositions(QByteArrayView data) const
 {
 	const char *constData = data.constData();
 	QList<quint32> positions;
@@ -29,5 +29,5 @@ public:
 	QByteArray save() const override;
 	inline int maxTutCount() const override { return 9; }
 protected:
-	QList<quint32> openPositions(const QByteArray &data) const override;
+	QList<quint32> openPositions(QByteArrayView data) const override;
 };
@@ -30,10 +30,12 @@ TutFileStandard::TutFileStandard(const QList<QByteArray> &tutos) :
 
 bool TutFileStandard::open()
 {
-	return TutFile::open(field()->sectionData(Field::Scripts));
+	QByteArray buffer;
+
+	return TutFile::open(field()->sectionView(Field::Scripts, buffer));
 }
 
-QList<quint32> TutFileStandard::openPositions(const QByteArray &data) const
+QList<quint32> TutFileStandard::openPositions(QByteArrayView data) const
 {
 	const char *constData = data.constData();
 	QList<quint32> positions;
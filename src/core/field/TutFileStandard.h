@@ -42,6 +42,6 @@ public:
 	void setAkaoID(int tutID, quint16 akaoID);
 	QString parseScripts(int tutID, bool *warnings = nullptr) const override;
 protected:
-	QList<quint32> openPositions(const QByteArray &data) const override;
+	QList<quint32> openPositions(QByteArrayView data) const override;
 	QByteArray save2(QByteArray &toc, quint32 firstPos) const;
 };
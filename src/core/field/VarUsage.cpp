@@ -0,0 +1,70 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include "VarUsage.h"
+#include <bitset>
+
+VarUsage::VarUsage() :
+    _usages(BankCount * AddressCount), _fields(BankCount * AddressCount)
+{
+}
+
+void VarUsage::clear()
+{
+	_usages.fill(Usage());
+	_fields.fill(QList<int>());
+}
+
+void VarUsage::addField(int mapID, const QList<FF7Var> &vars)
+{
+	std::bitset<BankCount * AddressCount> fieldVars;
+
+	for (const FF7Var &var : vars) {
+		const qsizetype i = index(var.bank, var.address);
+		Usage &usage = _usages[i];
+
+		if (var.flags.testFlag(FF7Var::Writable)) {
+			usage.writeCount += 1;
+		} else {
+			usage.readCount += 1;
+		}
+		usage.sizes |= quint8(1 << var.size);
+
+		if (!fieldVars.test(size_t(i))) {
+			fieldVars.set(size_t(i));
+			_fields[i].append(mapID);
+		}
+	}
+}
+
+void VarUsage::merge(const VarUsage &other)
+{
+	for (qsizetype i = 0; i < BankCount * AddressCount; ++i) {
+		const Usage &otherUsage = other._usages.at(i);
+
+		if (!otherUsage.isUsed()) {
+			continue;
+		}
+
+		Usage &usage = _usages[i];
+		usage.readCount += otherUsage.readCount;
+		usage.writeCount += otherUsage.writeCount;
+		usage.sizes |= otherUsage.sizes;
+
+		_fields[i].append(other._fields.at(i));
+	}
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#pragma once
+
+#include <QtCore>
+#include "Opcode.h"
+
+/*
+ * Read/write statistics of the field vars (banks 1 to 15),
+ * with the list of fields using each var.
+ * Stored as a flat bank/address table, fields are added one by one
+ * from the vars found in their scripts (see Section1File::searchAllVars()).
+ */
+class VarUsage
+{
+public:
+	struct Usage {
+		quint32 readCount = 0, writeCount = 0;
+		quint8 sizes = 0; // One bit per FF7Var::VarSize
+
+		inline bool isUsed() const {
+			return readCount > 0 || writeCount > 0;
+		}
+		inline bool hasSize(FF7Var::VarSize size) const {
+			return sizes & (1 << size);
+		}
+	};
+
+	VarUsage();
+
+	void clear();
+	void addField(int mapID, const QList<FF7Var> &vars);
+	// The fields of other must not be in this usage
+	void merge(const VarUsage &other);
+
+	inline const Usage &usage(quint8 bank, quint8 address) const {
+		return _usages.at(index(bank, address));
+	}
+	// Map IDs in the order of addition
+	inline const QList<int> &fields(quint8 bank, quint8 address) const {
+		return _fields.at(index(bank, address));
+	}
+private:
+	static constexpr qsizetype BankCount = 16, AddressCount = 256;
+
+	inline static qsizetype index(quint8 bank, quint8 address) {
+		return qsizetype(bank & 0xF) * AddressCount + address;
+	}
+
+	QList<Usage> _usages;
+	QList<QList<int>> _fields;
+};
@@ -42,9 +42,11 @@ int main(int argc, char *argv[])
 	if (!Data::load()) {
 		qWarning() << "Error loading data!";
 	}
-	CLI::exec();
+	const int exitCode = CLI::exec();
 
-	QTimer::singleShot(0, &app, &QCoreApplication::quit);
+	QTimer::singleShot(0, &app, [exitCode] {
+		QCoreApplication::exit(exitCode);
+	});
 #else
 
 	QApplication app(argc, argv);
@@ -44,7 +44,17 @@ void ApercuBG::fill(Field *field, bool reload)
 	}
 
 	_field = field;
-	QImage image = _field->background()->openBackground();
+
+	// Search default background params
+	QHash<quint8, quint8> paramActifs;
+	qint16 z[] = {-1, -1};
+	_field->scriptsAndTexts()->bgParamAndBgMove(paramActifs, z);
+	_compositor.setBackground(_field->background());
+	if (reload) {
+		_compositor.invalidate();
+	}
+	_compositor.setFilter(&paramActifs, z, nullptr, nullptr);
+	QImage image = _compositor.image();
 
 	if (image.isNull()) {
 		_background = errorPixmap(contentsRect().size());
@@ -100,6 +110,7 @@ void ApercuBG::clear()
 	QLabel::clear();
 	setCursor(Qt::ArrowCursor);
 	_field = nullptr;
+	_compositor.setBackground(nullptr);
 	_background = QPixmap();
 	_error = false;
 }
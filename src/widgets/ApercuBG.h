@@ -18,6 +18,7 @@
 #pragma once
 
 #include <QtWidgets>
+#include "core/field/BackgroundCompositor.h"
 
 class Field;
 
@@ -41,6 +42,7 @@ public slots:
 private:
 	static QPixmap errorPixmap(const QSize &size);
 	Field *_field;
+	BackgroundCompositor _compositor;
 	QPixmap _background;
 	QSize _backgroundSize;
 	bool _error;
@@ -117,6 +117,9 @@ void BGDialog::createEditorPage()
 {
 	editorPage = new BackgroundEditor();
 	
+	connect(editorPage, &BackgroundEditor::tilesChanged, this, [this](const QList<Tile> &tiles) {
+		_compositor.invalidate(tiles);
+	});
 	connect(editorPage, &BackgroundEditor::modified, this, &BGDialog::updateBG);
 	connect(editorPage, &BackgroundEditor::modified, this, &BGDialog::modified);
 
@@ -127,7 +130,7 @@ void BGDialog::createPalettesPage()
 {
 	palettesPage = new BackgroundPaletteEditor();
 
-	connect(palettesPage, &BackgroundPaletteEditor::modified, this, &BGDialog::updateBG);
+	connect(palettesPage, &BackgroundPaletteEditor::modified, this, &BGDialog::invalidateBG);
 	connect(palettesPage, &BackgroundPaletteEditor::modified, this, &BGDialog::modified);
 
 	stackedLayout->addWidget(palettesPage);
@@ -170,6 +173,8 @@ void BGDialog::fill(Field *field, bool reload)
 	}
 
 	_field = field;
+	_compositor.setBackground(_field->background());
+	_compositor.invalidate();
 	if (editorPage != nullptr) {
 		editorPage->clear();
 	}
@@ -192,6 +197,7 @@ void BGDialog::clear()
 	}
 
 	_field = nullptr;
+	_compositor.setBackground(nullptr);
 	allparams.clear();
 	params.clear();
 	image->clear();
@@ -455,7 +461,7 @@ void BGDialog::tryToRepairBG()
 	if (_field->background()->repair()) {
 		QMessageBox::information(this, tr("Background Repaired"), tr("Errors were found and repaired, save to apply the changes."));
 		emit modified();
-		updateBG();
+		invalidateBG();
 	} else {
 		QMessageBox::warning(this, tr("Repair Failed"), tr("The errors were not corrected."));
 	}
@@ -468,11 +474,20 @@ QImage BGDialog::background(bool *bgWarning)
 	}
 
 	if (tabBar->currentIndex() == 0) {
-		return _field->background()->openBackground(&params, z, layers, nullptr, false, false, bgWarning);
+		_compositor.setFilter(&params, z, layers, nullptr);
+	} else {
+		bool layers[4] = { false, true, false, false };
+		_compositor.setFilter(&params, z, layers, &sections);
 	}
 
-	bool layers[4] = { false, true, false, false };
-	return _field->background()->openBackground(&params, z, layers, &sections, false, false, bgWarning);
+	// Only the tiles which changed since the last call are drawn again
+	return _compositor.image(bgWarning);
+}
+
+void BGDialog::invalidateBG()
+{
+	_compositor.invalidate();
+	updateBG();
 }
 
 void BGDialog::updateBG()
@@ -484,13 +499,6 @@ void BGDialog::updateBG()
 	bool bgWarning;
 	QImage img = background(&bgWarning);
 
-	if (tabBar->currentIndex() == 0) {
-		img = _field->background()->openBackground(&params, z, layers, nullptr, false, false, &bgWarning);
-	} else {
-		bool layers[4] = { false, true, false, false };
-		img = _field->background()->openBackground(&params, z, layers, &sections, false, false, &bgWarning);
-	}
-
 	if (img.isNull()) {
 		image->setPixmap(QPixmap::fromImage(img));
 		bgWarning = false;
@@ -21,6 +21,7 @@
 #include "ApercuBGLabel.h"
 #include "BackgroundEditor.h"
 #include "BackgroundPaletteEditor.h"
+#include "core/field/BackgroundCompositor.h"
 
 class Field;
 
@@ -50,10 +51,12 @@ private slots:
 private:
 	void createEditorPage();
 	void createPalettesPage();
+	void invalidateBG();
 	QImage background(bool *bgWarning = nullptr);
 	void fillWidgets();
 
 	Field *_field;
+	BackgroundCompositor _compositor;
 	ApercuBGLabel *image;
 	QTabBar *mainTabBar;
 	QStackedLayout *stackedLayout;
@@ -133,6 +133,8 @@ void BackgroundEditor::showEvent(QShowEvent *event)
 void BackgroundEditor::setBackgroundFile(BackgroundFile *backgroundFile)
 {
 	_backgroundFile = backgroundFile;
+	_compositor.setBackground(backgroundFile);
+	_compositor.invalidate();
 
 	_layersComboBox->blockSignals(true);
 	_layersComboBox->setCurrentIndex(0);
@@ -186,6 +188,7 @@ void BackgroundEditor::refreshTexture()
 void BackgroundEditor::clear()
 {
 	_backgroundFile = nullptr;
+	_compositor.setBackground(nullptr);
 	_backgroundTileEditor->clear();
 	refreshList(0);
 	_backgroundLayerWidget->blockSignals(true);
@@ -462,9 +465,15 @@ void BackgroundEditor::refreshImage(int layer, int section, ParamState paramStat
 		}
 	}
 
-	QImage background = _backgroundFile->openBackground(
-	            layerTiles.tiles(layer).filter(!paramsEnabled.isEmpty() ? &paramsEnabled : nullptr, nullptr, nullptr, !sections.isEmpty() ? &sections : nullptr, !effectTileIds.isEmpty() ? &effectTileIds : nullptr, !paramsEnabled.isEmpty()),
-	            area, true);
+	// Only the current layer is drawn, layers is for the area and the shift
+	bool currentLayers[4] = {false, false, false, false};
+	if (layer < 4) {
+		currentLayers[layer] = true;
+	}
+	_compositor.setFilter(!paramsEnabled.isEmpty() ? &paramsEnabled : nullptr, nullptr, currentLayers, !sections.isEmpty() ? &sections : nullptr, !effectTileIds.isEmpty() ? &effectTileIds : nullptr, !paramsEnabled.isEmpty());
+	_compositor.setArea(area);
+	_compositor.setTransparent(true);
+	QImage background = _compositor.image();
 	QPixmap pix;
 
 	if (backgroundBelow.isNull()) {
@@ -511,38 +520,38 @@ void BackgroundEditor::updateSelectedTiles(const QList<Cell> &cells)
 		ParamState paramState = currentParamState();
 		QList<quint16> effectTileIds = currentEffect();
 		QMultiHash<Cell, Tile> matches;
-		BackgroundTiles tiles;
-
-		if (layerID >= 1 && paramState.isValid()) {
-			tiles = _backgroundFile->tiles().tiles(layerID, paramState);
-		} else if (layerID >= 1 && !effectTileIds.isEmpty()) {
-			tiles = _backgroundFile->tiles().tiles(layerID, false);
-		} else {
-			tiles = _backgroundFile->tiles().tiles(layerID, ID);
-		}
+		const BackgroundTileStore &store = _backgroundFile->tileStore();
+		const bool byParamState = layerID >= 1 && paramState.isValid(),
+		        byEffect = layerID >= 1 && !effectTileIds.isEmpty();
 
-		qDebug() << "updateSelectedTiles" << cellSize << layerID << ID << paramState.param << paramState.state << tiles.size();
+		qDebug() << "updateSelectedTiles" << cellSize << layerID << ID << paramState.param << paramState.state;
 		QPoint shift(_shiftX->value(), _shiftY->value());
-		
-		for (const Tile &tile : qAsConst(tiles)) {
-			if (layerID >= 1 && !effectTileIds.isEmpty() && !effectTileIds.contains(tile.tileID)) {
-				continue;
-			}
 
-			for (const Cell &cell: cells) {
-				QPoint dst = tilePositionFromCell(cell, cellSize, shift);
-				qint16 dstX = qint16(dst.x()),
-				        dstY = qint16(dst.y());
-
-				if (tile.dstX == dstX &&
-				        tile.dstY == dstY) {
-					qDebug() << tile.tileID << tile.dstX << tile.dstY;
-					selectedTiles.append(tile);
-					if (matches.contains(cell)) {
-						qWarning() << "Multi match!" << cell;
+		for (const Cell &cell: cells) {
+			QPoint dst = tilePositionFromCell(cell, cellSize, shift);
+
+			for (quint32 position : store.cell(layerID, qint16(dst.x()), qint16(dst.y()))) {
+				if (byParamState) {
+					if (store.param(position) != paramState.param
+					        || store.state(position) != paramState.state) {
+						continue;
 					}
-					matches.insert(cell, tile);
+				} else if (!byEffect && layerID == 1 && store.ID(position) != ID) {
+					continue;
+				}
+
+				const Tile &tile = store.tile(position);
+
+				if (byEffect && !effectTileIds.contains(tile.tileID)) {
+					continue;
 				}
+
+				qDebug() << tile.tileID << tile.dstX << tile.dstY;
+				selectedTiles.append(tile);
+				if (matches.contains(cell)) {
+					qWarning() << "Multi match!" << cell;
+				}
+				matches.insert(cell, tile);
 			}
 		}
 		
@@ -624,7 +633,8 @@ void BackgroundEditor::updateSelectedTileTexture(const Cell &cell)
 
 void BackgroundEditor::updateTiles(const QList<Tile> &tiles)
 {
-	Q_UNUSED(tiles)
+	_compositor.invalidate(tiles);
+	emit tilesChanged(tiles);
 
 	refreshImage(currentLayer(), currentSection(), currentParamState(), currentEffect());
 	refreshTexture();
@@ -21,6 +21,7 @@
 #include <ImageGridWidget.h>
 #include "BackgroundTileEditor.h"
 #include "core/field/BackgroundTiles.h"
+#include "core/field/BackgroundCompositor.h"
 
 class BackgroundFile;
 
@@ -34,6 +35,8 @@ public:
 	void saveConfig();
 signals:
 	void modified();
+	// Emitted before modified() when the tile editor changed tiles
+	void tilesChanged(const QList<Tile> &tiles);
 protected:
 	void showEvent(QShowEvent *event) override;
 private slots:
@@ -69,5 +72,6 @@ private:
 	BackgroundTileEditor *_backgroundTileEditor;
 
 	BackgroundFile *_backgroundFile;
+	BackgroundCompositor _compositor;
 	QList<quint8> _texIdKeys;
 };
@@ -26,7 +26,8 @@ Search::Search(Window *mainWindow) :
     fieldArchive(nullptr),
     text(QString()), clef(0),
     address(0), e_script(0), e_group(0), bank(0),
-    atTheEnd(false), atTheBeginning(false)
+    atTheEnd(false), atTheBeginning(false),
+    findAllSearch(nullptr), findAllThread(nullptr), findAllGeneration(0)
 {
 	setWindowTitle(tr("Find"));
 	
@@ -85,6 +86,7 @@ Search::Search(Window *mainWindow) :
 	connect(buttonNext, &QPushButton::clicked, this, &Search::findNext);
 	connect(buttonPrev, &QPushButton::clicked, this, &Search::findPrev);
 	connect(buttonAll, &QPushButton::clicked, this, &Search::findAll);
+	connect(searchAllDialog, &QDialog::finished, this, &Search::cancelFindAll);
 
 	connect(champ->lineEdit(), &QLineEdit::textEdited, champ2->lineEdit(), &QLineEdit::setText);
 	connect(caseSens, &QCheckBox::clicked, this, &Search::updateCaseSensitivity);
@@ -100,6 +102,17 @@ Search::Search(Window *mainWindow) :
 	updateCaseSensitivity(Config::value("findWithCaseSensitive").toBool());
 }
 
+Search::~Search()
+{
+	cancelFindAll();
+	if (findAllThread != nullptr) {
+		findAllThread->wait();
+		// The finished handler is disconnected with this object
+		delete findAllSearch;
+		delete findAllThread;
+	}
+}
+
 void Search::saveCurrentTab(int tab)
 {
 	Config::setValue("searchDialogCurrentModule", tab);
@@ -381,6 +394,7 @@ void Search::updateCaseSensitivity(bool cs)
 
 void Search::setFieldArchive(FieldArchive *fieldArchive)
 {
+	stopFindAll();
 	this->fieldArchive = fieldArchive;
 	searchAllDialog->setFieldArchive(fieldArchive);
 	updateRunSearch();
@@ -790,6 +804,11 @@ void Search::findAll()
 		mapID = mainWindow()->fieldList()->currentMapId();
 	}
 
+	if (scope == FieldArchive::GlobalScope) {
+		findAllInArchive();
+		return;
+	}
+
 	if (tabWidget->currentIndex() == 0) { // scripts page
 		int grpScriptID = -1, scriptID = -1, opcodeID = -1;
 
@@ -835,6 +854,98 @@ void Search::findAll()
 	setEnabled(true);
 }
 
+void Search::findAllInArchive()
+{
+	bool scriptSearch = tabWidget->currentIndex() == 0;
+	findAllSearch = new FieldArchiveSearch(fieldArchive);
+
+	if (scriptSearch) {
+		switch (liste->currentIndex()) {
+		case 0:
+			findAllSearch->setTextInScripts(text);
+			break;
+		case 1:
+			findAllSearch->setVar(bank, address, op, value);
+			break;
+		case 2:
+			findAllSearch->setOpcode(clef);
+			break;
+		case 3:
+			findAllSearch->setExec(e_group, e_script);
+			break;
+		case 4:
+			findAllSearch->setMapJump(map);
+			break;
+		}
+		searchAllDialog->setScriptSearch();
+	} else {
+		findAllSearch->setText(text);
+		searchAllDialog->setTextSearch();
+	}
+
+	FieldArchiveSearch *search = findAllSearch;
+	SearchAll *dialog = searchAllDialog;
+	const quint32 generation = ++findAllGeneration;
+
+	// The UI stays responsive, results are sent to the dialog in map order
+	QThread *thread = QThread::create([this, search, dialog, scriptSearch, generation]() {
+		search->findAll([this, dialog, scriptSearch, generation](int mapID, const QList<SearchResult> &results) {
+			Q_UNUSED(mapID)
+			QMetaObject::invokeMethod(this, [this, dialog, scriptSearch, generation, results]() {
+				if (generation != findAllGeneration) {
+					return;
+				}
+				for (const SearchResult &result : results) {
+					if (scriptSearch) {
+						dialog->addResultOpcode(result.mapID, result.groupID, result.scriptID, result.opcodeID);
+					} else {
+						dialog->addResultText(result.mapID, result.textID, int(result.index), int(result.size));
+					}
+				}
+			}, Qt::QueuedConnection);
+			return true;
+		});
+	});
+
+	findAllThread = thread;
+
+	// Another search may have been started since
+	connect(thread, &QThread::finished, this, [this, search, thread, generation]() {
+		delete search;
+		thread->deleteLater();
+		if (generation != findAllGeneration) {
+			return;
+		}
+		findAllSearch = nullptr;
+		findAllThread = nullptr;
+		mainWindow()->setEnabled(true);
+		setEnabled(true);
+	});
+
+	thread->start();
+}
+
+void Search::stopFindAll()
+{
+	cancelFindAll();
+	if (findAllThread != nullptr) {
+		findAllThread->wait();
+		// The search and the thread are freed by the finished handler
+		findAllSearch = nullptr;
+		findAllThread = nullptr;
+		mainWindow()->setEnabled(true);
+		setEnabled(true);
+	}
+	++findAllGeneration;
+}
+
+void Search::cancelFindAll()
+{
+	if (findAllSearch != nullptr) {
+		findAllSearch->cancel();
+	}
+}
+
 QRegularExpression Search::buildRegExp(const QString &lineEditText, bool caseSensitive, bool useRegexp)
 {
 	return QRegularExpression(useRegexp ? lineEditText : QRegularExpression::escape(lineEditText),
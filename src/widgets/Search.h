@@ -19,6 +19,7 @@
 
 #include <QtWidgets>
 #include "core/field/FieldArchive.h"
+#include "core/field/FieldArchiveSearch.h"
 #include "SearchAll.h"
 
 class Window;
@@ -29,6 +30,7 @@ class Search : public QDialog
 
 public:
 	explicit Search(Window *mainWindow);
+	virtual ~Search() override;
 
 	void setFieldArchive(FieldArchive *fieldArchive);
 	void setOpcode(int opcode, bool show = false);
@@ -47,6 +49,7 @@ private slots:
 	void findNext();
 	void findPrev();
 	void findAll();
+	void cancelFindAll();
 	void replaceCurrent();
 	void replaceAll();
 	void updateCaseSensitivity(bool cs);
@@ -64,6 +67,8 @@ private:
 		return reinterpret_cast<Window *>(parentWidget());
 	}
 	void setActionsEnabled(bool enable);
+	void findAllInArchive();
+	void stopFindAll();
 	bool findNextScript(FieldArchive::Sorting sorting, FieldArchive::SearchScope scope,
 	                    int &mapID, int &grpScriptID,
 	                    int &scriptID, int &opcodeID);
@@ -109,6 +114,10 @@ private:
 	quint8 bank;
 	bool cancel;
 	bool atTheEnd, atTheBeginning;
+	FieldArchiveSearch *findAllSearch;
+	QThread *findAllThread;
+	// Results and end of an older Find All are ignored
+	quint32 findAllGeneration;
 	QShortcut *findNextShortcut = nullptr;
 	QShortcut *findPreviousShortcut = nullptr;
 
@@ -278,7 +278,13 @@ void VarManager::search()
 	QTimer t(this);
 	connect(&t, &QTimer::timeout, this, &VarManager::processEvents);
 	t.start(700);
-	allVars = fieldArchive->searchAllVars(_fieldNames);
+	// A canceled search keeps the previous results
+	VarUsage varUsage;
+	if (!fieldArchive->searchAllVars(varUsage)) {
+		t.stop();
+		return;
+	}
+	_varUsage = std::move(varUsage);
 	quint8 b = quint8(bank->value());
 
 	for (quint16 address=0; address<256; ++address) {
@@ -295,19 +301,17 @@ void VarManager::processEvents() const
 
 void VarManager::findVar(const FF7Var &var, bool &foundR, bool &foundW, QSet<FF7Var::VarSize> &varSize)
 {
-	qsizetype index = -1;
+	const VarUsage::Usage &usage = _varUsage.usage(var.bank, var.address);
 
-	forever {
-		index = allVars.indexOf(var, index + 1);
-		if (index < 0) {
-			break;
-		}
-		FF7Var foundVar = allVars.at(index);
-		varSize.insert(foundVar.size);
-		if (foundVar.flags.testFlag(FF7Var::Writable)) {
-			foundW = true;
-		} else {
-			foundR = true;
+	if (usage.readCount > 0) {
+		foundR = true;
+	}
+	if (usage.writeCount > 0) {
+		foundW = true;
+	}
+	for (FF7Var::VarSize size : {FF7Var::Byte, FF7Var::Word, FF7Var::SignedWord, FF7Var::Bit}) {
+		if (usage.hasSize(size)) {
+			varSize.insert(size);
 		}
 	}
 }
@@ -361,5 +365,4 @@ void VarManager::colorizeItem(QTreeWidgetItem *item, const FF7Var &var)
 	}
 	item->setText(2, rwText);
 	item->setText(3, sizeText.join(", "));
-	//item->setText(4, QStringList(_fieldNames.value(var).toList()).join(", "));
 }
@@ -18,7 +18,7 @@
 #pragma once
 
 #include <QtWidgets>
-#include "core/field/Opcode.h"
+#include "core/field/VarUsage.h"
 
 class FieldArchive;
 
@@ -62,6 +62,5 @@ private:
 	QTreeWidget *liste2;
 
 	FieldArchive *fieldArchive;
-	QList<FF7Var> allVars;
-	QMap<FF7Var, QSet<QString> > _fieldNames;
+	VarUsage _varUsage;
 };
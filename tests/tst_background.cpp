@@ -0,0 +1,285 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtTest>
+#include "core/field/BackgroundFilePC.h"
+#include "core/field/BackgroundBlend.h"
+
+class TestBackground : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void drawBackground_data();
+	void drawBackground();
+	void parallelDrawing_data();
+	void parallelDrawing();
+	void blendRow_data();
+	void blendRow();
+private:
+	BackgroundFilePC *_background;
+};
+
+// Pixel by pixel drawing through BackgroundTextures::tile(), like the
+// implementation before the flat decode path
+static QImage drawBackgroundReference(const BackgroundFile *bg, const BackgroundTiles &tiles,
+                                      const QRect &area, bool transparent)
+{
+	QImage image(area.size(), QImage::Format_ARGB32);
+	image.fill(transparent ? 0 : 0xFF000000);
+	QRgb *pixels = reinterpret_cast<QRgb *>(image.bits());
+
+	for (const Tile &tile : tiles) {
+		QList<uint> indexOrColorList = bg->textures()->tile(tile);
+		quint8 depth = bg->textures()->depth(tile);
+		Palette *palette = nullptr;
+
+		if (indexOrColorList.isEmpty() || depth > 2
+		        || (depth <= 1 && tile.paletteID >= bg->palettes().size())) {
+			continue;
+		}
+		if (depth <= 1) {
+			palette = bg->palettes().at(tile.paletteID);
+		}
+
+		quint8 right = 0;
+		qint32 top = (area.y() + tile.dstY) * area.width();
+		qint32 baseX = area.x() + tile.dstX;
+
+		for (uint indexOrColor : qAsConst(indexOrColorList)) {
+			QRgb &pixel = pixels[baseX + right + top];
+			if (palette == nullptr) {
+				if (indexOrColor != 0) {
+					pixel = qRgb(qRed(indexOrColor), qGreen(indexOrColor), qBlue(indexOrColor));
+				}
+			} else if (palette->notZero(quint8(indexOrColor))) {
+				pixel = tile.blending
+				        ? BackgroundFile::blendColor(tile.typeTrans, pixel, palette->color(quint8(indexOrColor)))
+				        : palette->color(quint8(indexOrColor));
+			}
+
+			if (++right == tile.size) {
+				right = 0;
+				top += area.width();
+			}
+		}
+	}
+
+	return image;
+}
+
+// 320x224 background: one direct color and one paletted texture with random
+// pixels, layer 0 is a grid of tiles, the other layers are shifted and blended
+void TestBackground::initTestCase()
+{
+	QRandomGenerator random(1);
+	_background = new BackgroundFilePC(nullptr);
+
+	BackgroundTexturesPC *textures = new BackgroundTexturesPC();
+	BackgroundTexturesPCInfos infos;
+	infos.pos = 0;
+	infos.isBigTile = 0;
+	QList<uint> texture(256 * 256);
+
+	infos.depth = 2;
+	for (uint &color : texture) {
+		color = random.bounded(8) == 0 ? qRgba(0, 0, 0, 0) : (random.generate() | 0xFF000000);
+	}
+	textures->setTex(0, texture, infos);
+
+	infos.depth = 1;
+	for (uint &index : texture) {
+		index = random.bounded(256);
+	}
+	textures->setTex(1, texture, infos);
+	_background->setTextures(textures);
+
+	char palette[512];
+	for (int palID = 0; palID < 2; ++palID) {
+		for (int i = 0; i < 256; ++i) {
+			quint16 color = quint16(random.bounded(0x10000));
+			memcpy(palette + i * 2, &color, 2);
+		}
+		QVERIFY(_background->addPalette(palette));
+	}
+	// The first index of the second palette is transparent
+	static_cast<PalettePC *>(_background->palettes().at(1))->setTransparency(true);
+
+	QList<Tile> tiles;
+	quint16 tileID = 0;
+
+	for (quint8 layerID = 0; layerID < 4; ++layerID) {
+		const int shiftX = layerID * 5, shiftY = layerID * 7;
+
+		for (qint16 dstY = qint16(-112 + shiftY); dstY <= 96; dstY += 16) {
+			for (qint16 dstX = qint16(-160 + shiftX); dstX <= 144; dstX += 16) {
+				// Holes in the upper layers
+				if (layerID > 0 && random.bounded(3) == 0) {
+					continue;
+				}
+
+				Tile tile = Tile();
+				tile.dstX = dstX;
+				tile.dstY = dstY;
+				tile.srcX = quint8(random.bounded(16) * 16);
+				tile.srcY = quint8(random.bounded(16) * 16);
+				tile.size = 16;
+				tile.textureID = quint8(random.bounded(2));
+				tile.depth = tile.textureID == 0 ? 2 : 1;
+				tile.paletteID = quint8(random.bounded(2));
+				tile.layerID = layerID;
+				tile.ID = quint16(4095 - layerID * 100);
+				tile.blending = layerID > 0 && tile.depth == 1;
+				tile.typeTrans = quint8(random.bounded(4));
+				tile.tileID = tileID++;
+				tiles.append(tile);
+			}
+		}
+	}
+
+	_background->setTiles(BackgroundTiles(tiles));
+	_background->setOpen(true);
+
+	QCOMPARE(_background->tiles().rect().size(), QSize(320, 224));
+}
+
+void TestBackground::cleanupTestCase()
+{
+	delete _background;
+}
+
+void TestBackground::drawBackground_data()
+{
+	QTest::addColumn<bool>("transparent");
+
+	QTest::newRow("opaque") << false;
+	QTest::newRow("transparent") << true;
+}
+
+void TestBackground::drawBackground()
+{
+	QFETCH(bool, transparent);
+
+	const BackgroundTiles &tiles = _background->tiles();
+	const QRect area = tiles.rect();
+	bool warning = true;
+
+	const QImage image = _background->openBackground(tiles, area, transparent, &warning, 1);
+
+	QVERIFY(!warning);
+	QCOMPARE(image, drawBackgroundReference(_background, tiles, area, transparent));
+}
+
+static QByteArray imageBytes(const QImage &image)
+{
+	return QByteArray(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes());
+}
+
+void TestBackground::parallelDrawing_data()
+{
+	QTest::addColumn<int>("jobs");
+	QTest::addColumn<bool>("transparent");
+
+	for (int jobs : {2, 3, 4, 8, 0}) {
+		QTest::addRow("%d jobs, opaque", jobs) << jobs << false;
+		QTest::addRow("%d jobs, transparent", jobs) << jobs << true;
+	}
+}
+
+// Drawn in bands on several threads, the pixels must be exactly the serial ones
+void TestBackground::parallelDrawing()
+{
+	QFETCH(int, jobs);
+	QFETCH(bool, transparent);
+
+	const BackgroundTiles &tiles = _background->tiles();
+	const QRect area = tiles.rect();
+
+	QCOMPARE(imageBytes(_background->openBackground(tiles, area, transparent, nullptr, jobs)),
+	         imageBytes(_background->openBackground(tiles, area, transparent, nullptr, 1)));
+
+	for (quint8 layerID = 0; layerID < 4; ++layerID) {
+		const BackgroundTiles layer = tiles.tiles(layerID);
+
+		QCOMPARE(imageBytes(_background->openBackground(layer, area, transparent, nullptr, jobs)),
+		         imageBytes(_background->openBackground(layer, area, transparent, nullptr, 1)));
+	}
+}
+
+void TestBackground::blendRow_data()
+{
+	QTest::addColumn<int>("implementation");
+	QTest::addColumn<int>("type");
+
+	const char *names[] = {"scalar", "sse2", "avx2"};
+
+	for (int implementation : {BackgroundBlend::Scalar, BackgroundBlend::SSE2, BackgroundBlend::AVX2}) {
+		for (int type = 0; type < 4; ++type) {
+			QTest::addRow("%s, type %d", names[implementation], type) << implementation << type;
+		}
+	}
+}
+
+// Every SIMD implementation must give exactly the BackgroundFile::blendColor() pixels
+void TestBackground::blendRow()
+{
+	QFETCH(int, implementation);
+	QFETCH(int, type);
+
+	const BackgroundBlend::Implementation previous = BackgroundBlend::implementation();
+	BackgroundBlend::setImplementation(BackgroundBlend::Implementation(implementation));
+	const bool supported = BackgroundBlend::implementation() == implementation;
+	BackgroundBlend::setImplementation(previous);
+
+	if (!supported) {
+		QSKIP("Implementation not supported by this CPU");
+	}
+
+	// Edge colors first: alpha 0, black, white, saturation of every channel
+	QList<QRgb> dst = {0x00000000, 0x00FFFFFF, 0xFF000000, 0xFFFFFFFF,
+	                   0xFFFFFFFF, 0xFF000000, 0xFF808080, 0xFF7F7F7F,
+	                   0x00FF0000, 0xFF00FF00, 0xFF0000FF, 0xFF010203};
+	QList<QRgb> src = {0xFFFFFFFF, 0x00FFFFFF, 0xFFFFFFFF, 0x00000000,
+	                   0xFFFFFFFF, 0xFF000000, 0xFF808080, 0xFF818181,
+	                   0xFF0000FF, 0x00FFFFFF, 0xFFFF0000, 0xFF030201};
+	QList<quint32> masks(dst.size(), 0xFFFFFFFF);
+
+	// Then random pixels, with an odd tail for the vector loops
+	QRandomGenerator random(42);
+	while (dst.size() < 61) {
+		dst.append(random.generate());
+		src.append(random.generate());
+		masks.append(random.bounded(4) == 0 ? 0 : 0xFFFFFFFF);
+	}
+
+	QList<QRgb> expected = dst;
+	for (qsizetype i = 0; i < expected.size(); ++i) {
+		if (masks.at(i)) {
+			expected[i] = BackgroundFile::blendColor(quint8(type), dst.at(i), src.at(i));
+		}
+	}
+
+	BackgroundBlend::setImplementation(BackgroundBlend::Implementation(implementation));
+	BackgroundBlend::blendRow(quint8(type), dst.data(), src.constData(), masks.constData(), int(dst.size()));
+	BackgroundBlend::setImplementation(previous);
+
+	QCOMPARE(dst, expected);
+}
+
+QTEST_APPLESS_MAIN(TestBackground)
+#include "tst_background.moc"
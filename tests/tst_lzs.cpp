@@ -0,0 +1,120 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtTest>
+#include <LZS>
+#include "core/LzsDecoder.h"
+#include "core/LzsEncoder.h"
+
+class TestLzs : public QObject
+{
+	Q_OBJECT
+private slots:
+	void roundTrip_data();
+	void roundTrip();
+	void ringBufferPrefill();
+	void decompressInSteps();
+	void decompressRange();
+};
+
+static QByteArray randomData(qsizetype size, quint32 seed)
+{
+	QRandomGenerator random(seed);
+	QByteArray ret(size, Qt::Uninitialized);
+
+	for (qsizetype i = 0; i < size; ++i) {
+		ret[i] = char(random.bounded(256));
+	}
+
+	return ret;
+}
+
+void TestLzs::roundTrip_data()
+{
+	QTest::addColumn<QByteArray>("data");
+
+	QTest::newRow("empty") << QByteArray();
+	QTest::newRow("one byte") << QByteArray(1, 'a');
+	QTest::newRow("three bytes") << QByteArray("abc");
+	QTest::newRow("run of 18") << QByteArray(18, 'a');
+	QTest::newRow("run of 19") << QByteArray(19, 'a');
+	QTest::newRow("long run") << QByteArray(10000, 'a');
+	QTest::newRow("zeroes") << QByteArray(10000, '\0');
+	QTest::newRow("random") << randomData(10000, 1);
+	QTest::newRow("text") << QByteArray("Makou Reactor, Final Fantasy VII field archive editor. ").repeated(200);
+
+	// Longest distance allowed to the encoder, then one byte too far
+	const QByteArray block = randomData(0xFEE, 2);
+	QTest::newRow("distance 0xFEE") << block + block;
+	QTest::newRow("distance 0xFEF") << block + 'x' + block;
+	// Matches going over the 4 KiB ring buffer end several times
+	QTest::newRow("wrapped window") << (randomData(100, 3) + QByteArray(4000, 'b')).repeated(5);
+}
+
+void TestLzs::roundTrip()
+{
+	QFETCH(QByteArray, data);
+
+	for (LzsEncoder::Level level : {LzsEncoder::Fast, LzsEncoder::Default, LzsEncoder::MaxRatio}) {
+		const QByteArray compressed = LzsEncoder::compress(data, level);
+
+		QCOMPARE(LzsDecoder::decompressAll(compressed), data);
+		// The game and ff7tk must read it too
+		QCOMPARE(LZS::decompressAll(compressed), data);
+		QCOMPARE(LzsDecoder::decompressAllWithHeader(LzsEncoder::compressWithHeader(data, level)), data);
+	}
+}
+
+void TestLzs::ringBufferPrefill()
+{
+	// A reference of 18 bytes to the start of the ring buffer,
+	// before the first written byte, then the literal 'x'
+	const char compressed[] = {char(0xFE), char(0x00), char(0x0F), 'x'};
+
+	QCOMPARE(LzsDecoder::decompressAll(compressed, sizeof(compressed)),
+	         QByteArray(18, '\0') + 'x');
+}
+
+void TestLzs::decompressInSteps()
+{
+	const QByteArray data = (randomData(300, 4) + QByteArray(500, 'c')).repeated(20);
+	const QByteArray compressed = LzsEncoder::compress(data);
+	LzsDecoder decoder(compressed);
+
+	for (qsizetype max = 1; !decoder.atEnd(); max += 777) {
+		const qsizetype size = decoder.decompressTo(max);
+		QVERIFY(size >= qMin(max, data.size()));
+		QCOMPARE(decoder.data(0), data.left(size));
+	}
+
+	QCOMPARE(decoder.takeData(), data);
+}
+
+void TestLzs::decompressRange()
+{
+	const QByteArray data = randomData(2000, 5).repeated(3);
+	const QByteArray compressed = LzsEncoder::compressWithHeader(data);
+	LzsDecoder decoder(compressed, 4, compressed.size() - 4);
+
+	decoder.decompressTo(-1);
+
+	QVERIFY(decoder.atEnd());
+	QCOMPARE(decoder.takeData(), data);
+}
+
+QTEST_APPLESS_MAIN(TestLzs)
+#include "tst_lzs.moc"
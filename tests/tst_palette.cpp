@@ -0,0 +1,185 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtTest>
+#include <PsColor>
+#include "core/field/Palette.h"
+#include "core/field/BackgroundTextures.h"
+
+class TestPalette : public QObject
+{
+	Q_OBJECT
+private slots:
+	void colorTables_data();
+	void colorTables();
+	void colorTablesUpdate();
+	void directColors_data();
+	void directColors();
+	void directColorsRange();
+};
+
+// Random PS colors, with some black transparent (0) and semi transparent entries
+static QByteArray paletteData()
+{
+	QRandomGenerator random(1);
+	QByteArray ret(512, Qt::Uninitialized);
+
+	for (int i = 0; i < 256; ++i) {
+		quint16 color = i % 17 == 0 ? 0 : quint16(random.bounded(0x10000));
+		memcpy(ret.data() + i * 2, &color, 2);
+	}
+
+	return ret;
+}
+
+// Every 16-bit value
+static QByteArray directColorData()
+{
+	QByteArray ret(65536 * 2, Qt::Uninitialized);
+
+	for (int i = 0; i < 65536; ++i) {
+		quint16 color = quint16(i);
+		memcpy(ret.data() + i * 2, &color, 2);
+	}
+
+	return ret;
+}
+
+// Previous implementation of BackgroundTexturesPC::directColor
+static QRgb directColorPCReference(quint16 color)
+{
+	if (color == 0x0) {
+		return qRgba(0, 0, 0, 0);
+	}
+
+	if (color == 0x821) {
+		return qRgb(0, 0, 0);
+	}
+
+	quint8 b = color & 31,
+	       g = (color >> 6) & 31,
+	       r = color >> 11;
+
+	return qRgb((r << 3) + (r >> 2), (g << 3) + (g >> 2), (b << 3) + (b >> 2));
+}
+
+static bool sameTables(const Palette &palette)
+{
+	for (int i = 0; i < palette.size(); ++i) {
+		if (palette.colorTable()[i] != palette.color(i)
+		        || (palette.maskTable()[i] == 0xFFFFFFFF) != palette.notZero(quint8(i))
+		        || (palette.maskTable()[i] != 0 && palette.maskTable()[i] != 0xFFFFFFFF)) {
+			qWarning() << "different entry" << i;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void TestPalette::colorTables_data()
+{
+	QTest::addColumn<int>("type");
+
+	QTest::newRow("PS") << 0;
+	QTest::newRow("PC") << 1;
+	QTest::newRow("PC with transparency") << 2;
+}
+
+void TestPalette::colorTables()
+{
+	QFETCH(int, type);
+
+	const QByteArray data = paletteData();
+	QScopedPointer<Palette> palette(type == 0
+	                                ? new Palette(data.constData())
+	                                : new PalettePC(data.constData(), type == 2));
+
+	QCOMPARE(palette->size(), 256);
+	QVERIFY(sameTables(*palette));
+}
+
+void TestPalette::colorTablesUpdate()
+{
+	const QByteArray data = paletteData();
+	PalettePC palette(data.constData(), false);
+
+	palette.setColor(5, qRgb(1, 2, 3));
+	QCOMPARE(palette.colorTable()[5], qRgb(1, 2, 3));
+	QVERIFY(sameTables(palette));
+
+	palette.setTransparency(true);
+	QCOMPARE(palette.maskTable()[0], quint32(0));
+	QVERIFY(sameTables(palette));
+
+	PalettePC copy(palette);
+	QVERIFY(sameTables(copy));
+
+	// Without the PC rules
+	Palette psCopy(palette);
+	QVERIFY(sameTables(psCopy));
+
+	PalettePC pcCopy(psCopy, false);
+	QVERIFY(sameTables(pcCopy));
+}
+
+void TestPalette::directColors_data()
+{
+	QTest::addColumn<bool>("pc");
+
+	QTest::newRow("PC") << true;
+	QTest::newRow("PS") << false;
+}
+
+void TestPalette::directColors()
+{
+	QFETCH(bool, pc);
+
+	const QByteArray data = directColorData();
+	BackgroundTexturesPC texturesPC;
+	BackgroundTexturesPS texturesPS;
+	const BackgroundTextures *textures = pc ? static_cast<BackgroundTextures *>(&texturesPC) : &texturesPS;
+	QList<QRgb> colors(65536);
+
+	textures->directColors(reinterpret_cast<const uchar *>(data.constData()), 0, 65536, colors.data());
+
+	for (int i = 0; i < 65536; ++i) {
+		const QRgb reference = pc ? directColorPCReference(quint16(i)) : PsColor::fromPsColor(quint16(i), true);
+		if (colors.at(i) != reference) {
+			QFAIL(qPrintable(QString("Different color for %1: %2 instead of %3")
+			                 .arg(i, 4, 16, QChar('0'))
+			                 .arg(colors.at(i), 8, 16, QChar('0'))
+			                 .arg(reference, 8, 16, QChar('0'))));
+		}
+	}
+}
+
+void TestPalette::directColorsRange()
+{
+	const QByteArray data = directColorData();
+	BackgroundTexturesPC textures;
+	QList<QRgb> colors(64, 0x12345678);
+
+	textures.directColors(reinterpret_cast<const uchar *>(data.constData()), 10, 20, colors.data());
+
+	for (int i = 0; i < colors.size(); ++i) {
+		QCOMPARE(colors.at(i), i >= 10 && i < 20 ? directColorPCReference(quint16(i)) : QRgb(0x12345678));
+	}
+}
+
+QTEST_APPLESS_MAIN(TestPalette)
+#include "tst_palette.moc"
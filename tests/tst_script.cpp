@@ -0,0 +1,162 @@
+/****************************************************************************
+ ** Makou Reactor Final Fantasy VII Field Script Editor
+ ** Copyright (C) 2009-2022 Arzel Jérôme <myst6re@gmail.com>
+ **
+ ** This program is free software: you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation, either version 3 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** You should have received a copy of the GNU General Public License
+ ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ ****************************************************************************/
+#include <QtTest>
+#include "core/field/Script.h"
+
+class TestScript : public QObject
+{
+	Q_OBJECT
+private slots:
+	void packedScript();
+	void packedScriptModification();
+	void labels();
+	void manyLabels();
+	void badJump();
+};
+
+// IFUB to RET, JMPF to the second NOP, JMPB to the first NOP,
+// then a KAWAI opcode which has a variable size
+static const char scriptData[] = {
+	char(0x14), char(0x10), char(0x05), char(0x01), char(0x00), char(0x07), // 0: IFUB
+	char(0x5F), // 6: NOP
+	char(0x10), char(0x01), // 7: JMPF
+	char(0x5F), // 9: NOP
+	char(0x12), char(0x04), // 10: JMPB
+	char(0x00), // 12: RET
+	char(0x28), char(0x07), char(0x00), char(0x01), char(0x02), char(0x03), char(0x04) // 13: KAWAI
+};
+
+void TestScript::packedScript()
+{
+	const QByteArray data(scriptData, sizeof(scriptData));
+	Script script(scriptData, sizeof(scriptData));
+	QCOMPARE(script.toByteArray(), data);
+
+	Script packed = script;
+	packed.pack();
+	QVERIFY(packed.isPacked());
+	QVERIFY(packed.memoryUsage() < script.memoryUsage());
+	QCOMPARE(packed.size(), script.size());
+
+	for (qsizetype opcodeID = 0; opcodeID < script.size(); ++opcodeID) {
+		Opcode decoded, packedDecoded;
+		const Opcode &opcode = script.opcodeAt(opcodeID, decoded),
+		        &packedOpcode = packed.opcodeAt(opcodeID, packedDecoded);
+
+		QCOMPARE(packedOpcode.id(), opcode.id());
+		QCOMPARE(packedOpcode.toByteArray(), opcode.toByteArray());
+		QCOMPARE(packedOpcode.label(), opcode.label());
+		QCOMPARE(packedOpcode.resizableData(), opcode.resizableData());
+	}
+
+	// Read-only access keeps the script packed
+	QCOMPARE(packed.toByteArray(), data);
+	QVERIFY(packed.isPacked());
+
+	packed.opcodes();
+	QVERIFY(!packed.isPacked());
+	QCOMPARE(packed.toByteArray(), data);
+}
+
+void TestScript::packedScriptModification()
+{
+	Script script(scriptData, sizeof(scriptData));
+	script.pack();
+
+	// NOP removed, the other opcodes are unpacked unchanged
+	script.removeOpcode(2);
+	QVERIFY(!script.isPacked());
+
+	const QByteArray data(scriptData, sizeof(scriptData));
+	QCOMPARE(script.toByteArray(), data.left(6) + data.mid(7));
+}
+
+void TestScript::labels()
+{
+	Script script(scriptData, sizeof(scriptData));
+	// Labels are numbered by position: 1 at 6, 2 at 9, 3 at 12
+	const OpcodeKey ids[] = {
+		OpcodeKey::IFUB, OpcodeKey::LABEL, OpcodeKey::NOP, OpcodeKey::JMPF, OpcodeKey::LABEL,
+		OpcodeKey::NOP, OpcodeKey::JMPB, OpcodeKey::LABEL, OpcodeKey::RET, OpcodeKey::KAWAI
+	};
+	const int labels[] = {3, 1, -1, 2, 2, -1, 1, 3, -1, -1};
+
+	QCOMPARE(script.size(), qsizetype(sizeof(ids) / sizeof(*ids)));
+
+	for (qsizetype opcodeID = 0; opcodeID < script.size(); ++opcodeID) {
+		Opcode decoded;
+		const Opcode &opcode = script.opcodeAt(opcodeID, decoded);
+
+		QCOMPARE(opcode.id(), ids[opcodeID]);
+		QCOMPARE(opcode.label(), labels[opcodeID]);
+		if (opcode.isJump()) {
+			QCOMPARE(opcode.badJump(), BadJumpError::Ok);
+		}
+	}
+
+	// Jumps computed again from the labels
+	int opcodeID = 0;
+	QString errorStr;
+	QVERIFY(script.compile(opcodeID, errorStr));
+	QCOMPARE(script.toByteArray(), QByteArray(scriptData, sizeof(scriptData)));
+}
+
+void TestScript::manyLabels()
+{
+	// NOP then JMPB to this NOP, repeated: one label per NOP
+	const int count = 2000;
+	QByteArray data;
+	for (int i = 0; i < count; ++i) {
+		data.append("\x5F\x12\x01", 3);
+	}
+	data.append('\0'); // RET
+
+	Script script(data.constData(), data.size());
+	QCOMPARE(script.size(), qsizetype(count * 3 + 1));
+
+	for (int i = 0; i < count; ++i) {
+		Opcode decoded;
+		const Opcode &label = script.opcodeAt(i * 3, decoded);
+		QCOMPARE(label.id(), OpcodeKey::LABEL);
+		QCOMPARE(label.label(), i + 1);
+
+		const Opcode &jump = script.opcodeAt(i * 3 + 2, decoded);
+		QCOMPARE(jump.id(), OpcodeKey::JMPB);
+		QCOMPARE(jump.label(), i + 1);
+	}
+
+	QCOMPARE(script.toByteArray(), data);
+}
+
+void TestScript::badJump()
+{
+	// IFUB which jumps inside itself, no label is inserted
+	const char data[] = {
+		char(0x14), char(0x10), char(0x05), char(0x01), char(0x00), char(0x00), // 0: IFUB
+		char(0x00) // 6: RET
+	};
+	Script script(data, sizeof(data));
+
+	QCOMPARE(script.size(), qsizetype(2));
+	QCOMPARE(script.opcode(0).badJump(), BadJumpError::InsideInstruction);
+	QCOMPARE(script.opcode(1).id(), OpcodeKey::RET);
+	QCOMPARE(script.toByteArray(), QByteArray(data, sizeof(data)));
+}
+
+QTEST_APPLESS_MAIN(TestScript)
+#include "tst_script.moc"